@@ -0,0 +1,23 @@
+#
+# Copyright (c) 2025 Nick Marino
+# All rights reserved.
+#
+
+# Converts the SPIR-V binary INPUT into a list of 32-bit words in OUTPUT, to
+# be included into a C++ array initializer.
+#
+#   cmake -DINPUT=<file.spv> -DOUTPUT=<file.inc> -P EmbedSpirv.cmake
+
+file(READ ${INPUT} hex HEX)
+
+string(LENGTH "${hex}" num_digits)
+math(EXPR remainder "${num_digits} % 8")
+if (num_digits EQUAL 0 OR NOT remainder EQUAL 0)
+    message(FATAL_ERROR "${INPUT} is not a SPIR-V binary.")
+endif()
+
+# SPIR-V is written in host byte order, which is little endian on every
+# supported target, so reverse the bytes of each word.
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u,\n" words "${hex}")
+
+file(WRITE ${OUTPUT} "${words}")
@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/GCLContext.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+static void print_budgets(const gcl::GCLContext& ctx) {
+    for (const gcl::HeapBudget& heap : ctx.get_memory_budgets()) {
+        std::cout << "heap " << heap.heap 
+            << (heap.device_local ? " (device)" : " (host)  ")
+            << "  usage: " << (heap.usage >> 20) << " MiB"
+            << "  budget: " << (heap.budget >> 20) << " MiB"
+            << "  size: " << (heap.size >> 20) << " MiB\n";
+    }
+}
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc != 3) {
+        std::cout << "usage: ./budget <MiB per buffer> <soft limit>" 
+            << std::endl;
+        return 1;
+    }
+
+    const uint64_t N = (std::stoull(argv[1]) << 20) / sizeof(float);
+
+    gcl::GCLContext ctx(gcl::Backend::Device);
+    ctx.set_soft_limit(std::stod(argv[2]));
+
+    std::cout << "VK_EXT_memory_budget: " 
+        << (ctx.has_device_extension("VK_EXT_memory_budget") ? "yes" : "no")
+        << '\n';
+
+    print_budgets(ctx);
+
+    // Allocate until a few buffers have spilled to host memory.
+    std::vector<std::unique_ptr<gcl::Buffer<float>>> buffers;
+    while (ctx.get_spill_count() < 4) {
+        buffers.push_back(std::make_unique<gcl::Buffer<float>>(ctx, N));
+        std::cout << "buffer " << buffers.size() 
+            << (buffers.back()->spilled() ? ": spilled\n" : ": device\n");
+    }
+
+    print_budgets(ctx);
+    return 0;
+}
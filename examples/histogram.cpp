@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/GCLContext.h"
+#include "../include/Histogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc != 4) {
+        std::cout << "usage: ./histogram <N> <bins> <iterations>"
+            << std::endl;
+        return 1;
+    }
+
+    const uint32_t N = std::stoul(argv[1]);
+    const uint32_t bins = std::stoul(argv[2]);
+    const uint32_t iterations = std::stoul(argv[3]);
+
+    gcl::GCLContext ctx(gcl::Backend::Device);
+
+    std::mt19937 rng(7);
+    std::normal_distribution<float> normal(0.f, 1.f);
+
+    std::vector<float> values(N);
+    for (float& value : values)
+        value = normal(rng);
+
+    gcl::Buffer<float> buf(ctx, N);
+    buf.send(values);
+
+    gcl::Histogram<float> histogram(ctx, -4.f, 4.f, bins);
+    std::cout << "passes: " << histogram.get_passes() << '\n';
+
+    std::vector<uint32_t> counts = histogram.compute(buf);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+        counts = histogram.compute(buf);
+
+    std::chrono::duration<double, std::micro> device =
+        std::chrono::steady_clock::now() - start;
+
+    // The alternative: fetch every value and count on the host.
+    const std::vector<float>& edges = histogram.get_edges();
+    std::vector<uint32_t> expected(bins);
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        std::fill(expected.begin(), expected.end(), 0);
+        for (float value : buf.fetch()) {
+            if (!(value >= edges.front() && value <= edges.back()))
+                continue;
+
+            auto it = std::upper_bound(edges.begin(), edges.end(), value);
+            uint32_t bin = std::min<uint32_t>(it - edges.begin() - 1,
+                bins - 1);
+            ++expected[bin];
+        }
+    }
+
+    std::chrono::duration<double, std::micro> host =
+        std::chrono::steady_clock::now() - start;
+
+    uint32_t mismatches = 0;
+    for (uint32_t bin = 0; bin < bins; ++bin)
+        mismatches += counts[bin] != expected[bin];
+
+    std::cout << "device: " << device.count() / iterations << " us\n";
+    std::cout << "fetch + host: " << host.count() / iterations << " us\n";
+    std::cout << "mismatched bins: " << mismatches << '\n';
+
+    return mismatches == 0 ? 0 : 1;
+}
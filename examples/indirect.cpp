@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/GCLContext.h"
+#include "../include/Indirect.h"
+#include "../include/Kernel.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// Push constants of kernels/filter.comp.
+struct FilterParams {
+    float threshold;
+    uint32_t n;
+};
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc != 2) {
+        std::cout << "usage: ./indirect <N>" << std::endl;
+        return 1;
+    }
+
+    gcl::GCLContext ctx(gcl::Backend::Device);
+    const uint32_t N = std::stoul(argv[1]);
+
+    gcl::Buffer<float> a(ctx, N);
+    gcl::Buffer<float> survivors(ctx, N);
+    gcl::Buffer<float> r(ctx, N);
+    gcl::Buffer<uint32_t> count(ctx, 1);
+    gcl::Buffer<uint32_t> args(ctx, 3);
+
+    std::vector<float> va(N);
+    for (uint32_t i = 0; i < N; ++i)
+        va[i] = float(i % 100) / 100.f;
+
+    a.send(va);
+    count.send({ 0 });
+
+    // Keep the values above the threshold, then square the survivors. The 
+    // number of survivors is only ever known on the device.
+    gcl::Kernel filter(ctx, gcl::embedded::filter);
+    filter.bind(0, a);
+    filter.bind(1, survivors);
+    filter.bind(2, count);
+    filter.push(FilterParams { 0.9f, N });
+
+    gcl::Kernel square(ctx, gcl::embedded::square);
+    square.bind(0, count);
+    square.bind(1, survivors);
+    square.bind(2, r);
+
+    gcl::IndirectArgs groups(ctx);
+
+    filter.dispatch(N);
+    groups.compute(square, count, 0, args);
+    square.dispatch_indirect(args);
+
+    // Only read the count back to print the results.
+    uint32_t survived = count.fetch()[0];
+    std::vector<float> out = r.fetch();
+    for (uint32_t i = 0; i < survived; ++i)
+        std::cout << "r[" << i << "] = " << out[i] << '\n';
+
+    return 0;
+}
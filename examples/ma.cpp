@@ -33,7 +33,7 @@ int32_t main(int32_t argc, char** argv) {
     a.send(va);
     b.send(vb);
 
-    gcl::Kernel k(ctx, "kernels/ma.spv");
+    gcl::Kernel k(ctx, gcl::embedded::ma);
     k.bind(0, a);
     k.bind(1, b);
     k.bind(2, r);
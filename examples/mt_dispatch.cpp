@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/GCLContext.h"
+#include "../include/Kernel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Runs |dispatches| dispatches of the ma kernel on each of |num_threads| 
+/// threads sharing |ctx|, and returns the aggregate dispatches per second.
+static double run(gcl::GCLContext& ctx, uint32_t N, uint32_t dispatches,
+                  uint32_t num_threads) {
+    std::atomic<uint32_t> ready = 0;
+    std::atomic<bool> go = false;
+    std::vector<std::thread> threads;
+
+    for (uint32_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&]() {
+            gcl::Buffer<float> a(ctx, N);
+            gcl::Buffer<float> b(ctx, N);
+            gcl::Buffer<float> r(ctx, N);
+
+            a.send(std::vector<float>(N, 1.f));
+            b.send(std::vector<float>(N, 2.f));
+
+            gcl::Kernel k(ctx, gcl::embedded::ma);
+            k.bind(0, a);
+            k.bind(1, b);
+            k.bind(2, r);
+
+            // Warm up the thread's command pool before timing starts.
+            k.dispatch(N);
+
+            ++ready;
+            while (!go.load())
+                std::this_thread::yield();
+
+            for (uint32_t i = 0; i < dispatches; ++i)
+                k.dispatch(N);
+        });
+    }
+
+    while (ready.load() != num_threads)
+        std::this_thread::yield();
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+
+    for (auto& thread : threads)
+        thread.join();
+
+    std::chrono::duration<double> elapsed = 
+        std::chrono::steady_clock::now() - start;
+
+    return double(num_threads) * dispatches / elapsed.count();
+}
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc < 3 || argc > 4) {
+        std::cout << "usage: ./mt_dispatch <N> <dispatches> [max threads]" 
+            << std::endl;
+        return 1;
+    }
+
+    const uint32_t N = std::stoul(argv[1]);
+    const uint32_t dispatches = std::stoul(argv[2]);
+    const uint32_t max_threads = argc == 4 
+        ? std::stoul(argv[3]) 
+        : std::max(1u, std::thread::hardware_concurrency());
+
+    gcl::GCLContext ctx(gcl::Backend::Device);
+
+    // Measure the device path even for small N.
+    ctx.set_host_threshold(0);
+
+    std::cout << "compute queues: " << ctx.get_compute_queue_count() << '\n';
+
+    double base = 0.0;
+    for (uint32_t t = 1; t <= max_threads; t *= 2) {
+        double rate = run(ctx, N, dispatches, t);
+        if (t == 1)
+            base = rate;
+
+        std::cout << "threads: " << t 
+            << "  dispatches/s: " << uint64_t(rate)
+            << "  scaling: " << rate / base << "x\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/Convert.h"
+#include "../include/GCLContext.h"
+#include "../include/Kernel.h"
+#include "../include/Types.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc != 2) {
+        std::cout << "usage: ./precision <N>" << std::endl;
+        return 1;
+    }
+
+    gcl::GCLContext ctx;
+    const uint32_t N = std::stoul(argv[1]);
+
+    std::vector<float> va(N), vb(N);
+    std::vector<gcl::half> ha(N), hb(N);
+    for (uint32_t i = 0; i < N; ++i) {
+        va[i] = float(i % 1000) / 1000.f;
+        vb[i] = float(i % 2048) * 0.0003f;
+        ha[i] = gcl::half(va[i]);
+        hb[i] = gcl::half(vb[i]);
+    }
+
+    // Inputs and results move as binary16, compute happens in fp32.
+    gcl::Buffer<gcl::half> a16(ctx, N);
+    gcl::Buffer<gcl::half> b16(ctx, N);
+    gcl::Buffer<gcl::half> r16(ctx, N);
+    gcl::Buffer<float> a(ctx, N);
+    gcl::Buffer<float> b(ctx, N);
+    gcl::Buffer<float> r(ctx, N);
+
+    a16.send(ha);
+    b16.send(hb);
+
+    gcl::Converter convert(ctx);
+    convert.expand(a16, a);
+    convert.expand(b16, b);
+
+    gcl::Kernel k(ctx, gcl::embedded::ma);
+    k.bind(0, a);
+    k.bind(1, b);
+    k.bind(2, r);
+    k.dispatch(N);
+
+    convert.pack(r, r16);
+    std::vector<gcl::half> out = r16.fetch();
+
+    float max_err = 0.f;
+    for (uint32_t i = 0; i < N; ++i) {
+        float expected = va[i] * vb[i] + 1.f;
+        max_err = std::max(max_err, std::fabs(float(out[i]) - expected));
+    }
+
+    std::cout << "16-bit storage: " 
+        << (ctx.get_features().storage_buffer_16bit ? "native" : "emulated")
+        << '\n';
+    std::cout << "bytes moved: " << 3 * r16.size() 
+        << " (fp32: " << 3 * r.size() << ")\n";
+    std::cout << "max error: " << max_err << '\n';
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/GCLContext.h"
+#include "../include/Profile.h"
+
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc > 2 || (argc == 2 && std::string(argv[1]) != "--cached")) {
+        std::cout << "usage: ./probe [--cached]" << std::endl;
+        return 1;
+    }
+
+    gcl::GCLContext ctx(gcl::Backend::Device);
+
+    // Print the cached profile, if asked to and there is one, and measure
+    // and cache a new one otherwise.
+    std::optional<gcl::DeviceProfile> cached;
+    if (argc == 2)
+        cached = gcl::load_profile(ctx);
+
+    gcl::DeviceProfile profile = cached ? *cached : gcl::probe(ctx);
+    std::string path = gcl::get_profile_path(profile.uuid);
+
+    if (!cached && !gcl::save_profile(profile))
+        std::cout << "failed to write " << path << '\n';
+
+    std::cout << "device:            " << profile.device_name << '\n';
+    std::cout << "uuid:              " << profile.uuid << '\n';
+    std::cout << "upload:            " << profile.upload_gbps << " GB/s\n";
+    std::cout << "download:          " << profile.download_gbps << " GB/s\n";
+    std::cout << "device memory:     " << profile.device_gbps << " GB/s\n";
+    std::cout << "empty dispatch:    " << profile.dispatch_us << " us\n";
+    std::cout << "submit to fence:   " << profile.submit_us << " us\n";
+    std::cout << "host ma:           " << profile.host_ns << " ns\n";
+    std::cout << "host threshold:    " << profile.host_threshold << '\n';
+    std::cout << "host grain:        " << profile.host_grain << '\n';
+    std::cout << "saturating size:   " << profile.saturating_invocations
+              << " invocations\n";
+    std::cout << (cached ? "read from " : "cached at ") << path << '\n';
+
+    return 0;
+}
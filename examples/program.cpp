@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/GCLContext.h"
+#include "../include/Kernel.h"
+#include "../include/Program.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc != 3) {
+        std::cout << "usage: ./program <N> <iterations>" << std::endl;
+        return 1;
+    }
+
+    gcl::GCLContext ctx(gcl::Backend::Device);
+    const uint32_t N = std::stoul(argv[1]);
+    const uint32_t iterations = std::stoul(argv[2]);
+
+    // Measure the device path even for small N.
+    ctx.set_host_threshold(0);
+
+    gcl::Buffer<float> a(ctx, N);
+    gcl::Buffer<float> b(ctx, N);
+    gcl::Buffer<float> r(ctx, N);
+    gcl::Buffer<float> s(ctx, N);
+
+    std::vector<float> va(N), vb(N);
+    for (uint32_t i = 0; i < N; ++i) {
+        va[i] = float(i % 1000) / 1000.f;
+        vb[i] = float(i % 2048) * 0.0003f;
+    }
+
+    a.send(va);
+    b.send(vb);
+
+    // r = ma(a, b), s = branch(r, b), r = heavy(s, b)
+    gcl::Kernel ma(ctx, gcl::embedded::ma);
+    ma.bind(0, a);
+    ma.bind(1, b);
+    ma.bind(2, r);
+
+    gcl::Kernel branch(ctx, gcl::embedded::branch);
+    branch.bind(0, r);
+    branch.bind(1, b);
+    branch.bind(2, s);
+
+    gcl::Kernel heavy(ctx, gcl::embedded::heavy);
+    heavy.bind(0, s);
+    heavy.bind(1, b);
+    heavy.bind(2, r);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        ma.dispatch(N);
+        branch.dispatch(N);
+        heavy.dispatch(N);
+    }
+
+    std::chrono::duration<double, std::micro> direct = 
+        std::chrono::steady_clock::now() - start;
+    std::vector<float> expected = r.fetch();
+
+    gcl::Program program(ctx);
+    program.add(ma, N);
+    program.add(branch, N);
+    program.add(heavy, N);
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+        program.run();
+
+    std::chrono::duration<double, std::micro> recorded = 
+        std::chrono::steady_clock::now() - start;
+    std::vector<float> out = r.fetch();
+
+    // Rebinding, like changing push constants, re-records every step on the
+    // next run.
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        ma.bind(2, r);
+        program.run();
+    }
+
+    std::chrono::duration<double, std::micro> rerecorded = 
+        std::chrono::steady_clock::now() - start;
+
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+        if (out[i] != expected[i])
+            ++mismatches;
+    }
+
+    std::cout << "Kernel::dispatch: " << direct.count() / iterations 
+        << "us per iteration\n";
+    std::cout << "Program::run:     " << recorded.count() / iterations
+        << "us per iteration\n";
+    std::cout << "re-recorded run:  " << rerecorded.count() / iterations
+        << "us per iteration\n";
+    std::cout << "mismatches: " << mismatches << '\n';
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Async.h"
+#include "../include/Buffer.h"
+#include "../include/GCLContext.h"
+#include "../include/Kernel.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// The buffers and kernel of a single job.
+struct Job {
+    gcl::Buffer<float> a;
+    gcl::Buffer<float> b;
+    gcl::Buffer<float> r;
+    gcl::Kernel kernel;
+
+    Job(gcl::GCLContext& ctx, uint32_t N)
+            : a(ctx, N), b(ctx, N), r(ctx, N),
+              kernel(ctx, gcl::embedded::ma) {
+        kernel.bind(0, a);
+        kernel.bind(1, b);
+        kernel.bind(2, r);
+    }
+};
+
+/// Uploads the inputs of |job|, runs |dispatches| dispatches and checks the
+/// result, suspending on the reactor while the device works.
+static gcl::Task run_job(gcl::Reactor& reactor, Job& job, uint32_t N,
+                         uint32_t dispatches, uint32_t* failures) {
+    std::vector<float> va(N, 1.f);
+    std::vector<float> vb(N, 2.f);
+
+    co_await gcl::async_send(job.a, va);
+    co_await gcl::async_send(job.b, vb);
+
+    for (uint32_t i = 0; i < dispatches; ++i)
+        co_await gcl::async_dispatch(reactor, job.kernel, N);
+
+    std::vector<float> r = co_await gcl::async_fetch(job.r);
+    for (float value : r) {
+        if (value != 3.f) {
+            ++*failures;
+            break;
+        }
+    }
+}
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc != 4) {
+        std::cout << "usage: ./reactor <N> <jobs> <dispatches>" << std::endl;
+        return 1;
+    }
+
+    const uint32_t N = std::stoul(argv[1]);
+    const uint32_t num_jobs = std::stoul(argv[2]);
+    const uint32_t dispatches = std::stoul(argv[3]);
+
+    gcl::GCLContext ctx(gcl::Backend::Device);
+
+    // Measure the device path even for small N.
+    ctx.set_host_threshold(0);
+
+    std::cout << "completion: "
+        << (ctx.has_fence_fd() ? "sync file" : "waiter thread") << '\n';
+
+    std::vector<std::unique_ptr<Job>> jobs;
+    for (uint32_t j = 0; j < num_jobs; ++j)
+        jobs.push_back(std::make_unique<Job>(ctx, N));
+
+    // Every job in turn on the calling thread, blocking on each dispatch.
+    auto start = std::chrono::steady_clock::now();
+    for (auto& job : jobs) {
+        for (uint32_t i = 0; i < dispatches; ++i)
+            job->kernel.dispatch(N);
+    }
+
+    std::chrono::duration<double> blocking =
+        std::chrono::steady_clock::now() - start;
+
+    // Every job at once, driven by a single reactor thread.
+    gcl::Reactor reactor;
+    uint32_t failures = 0;
+
+    start = std::chrono::steady_clock::now();
+    for (auto& job : jobs)
+        reactor.spawn(run_job(reactor, *job, N, dispatches, &failures));
+
+    reactor.run();
+
+    std::chrono::duration<double> async =
+        std::chrono::steady_clock::now() - start;
+
+    double total = double(num_jobs) * dispatches;
+    std::cout << "blocking: " << uint64_t(total / blocking.count())
+        << " dispatches/s\n";
+    std::cout << "reactor:  " << uint64_t(total / async.count())
+        << " dispatches/s\n";
+    std::cout << "failed jobs: " << failures << '\n';
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/GCLContext.h"
+#include "../include/Host.h"
+#include "../include/Kernel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// Runs |name| on the device and on the host over the same inputs, and 
+/// reports the time of each and the largest difference between them.
+static void compare(gcl::GCLContext& ctx, const std::string& name, 
+                    uint32_t N) {
+    gcl::Buffer<float> a(ctx, N);
+    gcl::Buffer<float> b(ctx, N);
+    gcl::Buffer<float> r(ctx, N);
+
+    std::vector<float> va(N), vb(N);
+    for (uint32_t i = 0; i < N; ++i) {
+        va[i] = float(i % 1000) / 1000.f;
+        vb[i] = float(i % 2048) * 0.0003f;
+    }
+
+    a.send(va);
+    b.send(vb);
+
+    gcl::Kernel k(ctx, *gcl::embedded::find(name));
+    k.bind(0, a);
+    k.bind(1, b);
+    k.bind(2, r);
+
+    auto start = std::chrono::steady_clock::now();
+    k.dispatch(N);
+    auto mid = std::chrono::steady_clock::now();
+    std::vector<float> device = r.fetch();
+
+    auto host_start = std::chrono::steady_clock::now();
+    k.dispatch_host(N);
+    auto end = std::chrono::steady_clock::now();
+    std::vector<float> host = r.fetch();
+
+    float max_err = 0.f;
+    for (uint32_t i = 0; i < N; ++i)
+        max_err = std::max(max_err, std::fabs(device[i] - host[i]));
+
+    std::chrono::duration<double, std::micro> device_us = mid - start;
+    std::chrono::duration<double, std::micro> host_us = end - host_start;
+
+    std::cout << name 
+        << "  device: " << device_us.count() << "us"
+        << "  host: " << host_us.count() << "us"
+        << "  max error: " << max_err << '\n';
+}
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc != 2) {
+        std::cout << "usage: ./reference <N>" << std::endl;
+        return 1;
+    }
+
+    const uint32_t N = std::stoul(argv[1]);
+
+    gcl::GCLContext ctx(gcl::Backend::Device);
+
+    // Route every dispatch to the device so it can be compared to the host.
+    ctx.set_host_threshold(0);
+
+    std::cout << "host isa: " << gcl::host::to_string(gcl::host::detect_isa())
+        << ", threads: " << gcl::host::get_num_threads() << '\n';
+
+    for (const std::string& name : { "ma", "branch", "heavy" })
+        compare(ctx, name, N);
+
+    return 0;
+}
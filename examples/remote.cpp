@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Remote.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc < 3 || argc > 4) {
+        std::cout << "usage: ./remote <N> <iterations> [socket path]"
+            << std::endl;
+        return 1;
+    }
+
+    const uint32_t iterations = std::stoul(argv[2]);
+    const std::string path = argc == 4
+        ? argv[3]
+        : gcl::remote::default_socket_path();
+
+    // Start gcld first, e.g. with ./tools/gcld.
+    gcl::RemoteContext ctx(path);
+    gcl::RemoteKernel k(ctx, gcl::embedded::ma);
+
+    // The ma kernel has no bounds check, so N is rounded up to whole 
+    // workgroups.
+    const uint32_t local_size = k.get_local_size_x();
+    const uint32_t N = (std::stoul(argv[1]) + local_size - 1) 
+        / local_size * local_size;
+
+    gcl::RemoteBuffer<float> a(ctx, N);
+    gcl::RemoteBuffer<float> b(ctx, N);
+    gcl::RemoteBuffer<float> r(ctx, N);
+
+    std::vector<float> va(N), vb(N);
+    for (uint32_t i = 0; i < N; ++i) {
+        va[i] = float(i % 1000);
+        vb[i] = 2.f;
+    }
+
+    a.send(va);
+    b.send(vb);
+
+    k.bind(0, a);
+    k.bind(1, b);
+    k.bind(2, r);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+        k.dispatch(N);
+
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    uint32_t mismatches = 0;
+    std::vector<float> out = r.fetch();
+    for (uint32_t i = 0; i < N; ++i)
+        mismatches += out[i] != va[i] * vb[i] + 1.f;
+
+    std::cout << "remote dispatch: " << elapsed.count() / iterations 
+        << " us\n";
+    std::cout << "mismatches: " << mismatches << '\n';
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Remote.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+/// Returns true if |request| fails with an error containing |expected|.
+static bool expect_error(gcl::RemoteContext& ctx,
+                         const gcl::remote::Request& request,
+                         const std::string& expected, int fd = -1) {
+    try {
+        ctx.request(request, fd);
+    } catch (const std::exception& e) {
+        return std::string(e.what()).find(expected) != std::string::npos;
+    }
+
+    return false;
+}
+
+static uint32_t g_failures = 0;
+
+static void check(const char* what, bool ok) {
+    std::cout << (ok ? "ok      " : "FAILED  ") << what << '\n';
+    g_failures += !ok;
+}
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc > 2) {
+        std::cout << "usage: ./remote_errors [socket path]" << std::endl;
+        return 1;
+    }
+
+    const std::string path = argc == 2
+        ? argv[1]
+        : gcl::remote::default_socket_path();
+
+    // Start gcld first, e.g. with ./tools/gcld. Every bad request must be
+    // refused with an error, leaving the daemon serving the same client.
+    gcl::RemoteContext ctx(path);
+    gcl::RemoteKernel k(ctx, gcl::embedded::ma);
+
+    const uint32_t N = k.get_local_size_x();
+    gcl::RemoteBuffer<float> a(ctx, N);
+    gcl::RemoteBuffer<float> b(ctx, N);
+    gcl::RemoteBuffer<float> r(ctx, N);
+
+    a.send(std::vector<float>(N, 3.f));
+    b.send(std::vector<float>(N, 2.f));
+
+    gcl::remote::Request dispatch;
+    dispatch.op = gcl::remote::Op::Dispatch;
+    dispatch.id = k.id();
+    dispatch.x = N;
+    dispatch.bindings[0] = a.id();
+    dispatch.bindings[1] = b.id();
+    check("unbound binding",
+        expect_error(ctx, dispatch, "binding 2 of the kernel is unbound"));
+
+    dispatch.bindings[2] = r.id();
+    dispatch.x = std::numeric_limits<uint32_t>::max();
+    dispatch.y = std::numeric_limits<uint32_t>::max();
+    check("too many groups",
+        expect_error(ctx, dispatch, "exceeds the device limit"));
+
+    dispatch.x = N;
+    dispatch.y = 1;
+    dispatch.z = 0;
+    check("empty dimension",
+        expect_error(ctx, dispatch, "must be nonzero"));
+
+    dispatch.z = 1;
+    dispatch.bindings[2] = 1000;
+    check("unknown buffer", expect_error(ctx, dispatch, "no such buffer"));
+
+    // ma declares bindings 0 to 2 only.
+    dispatch.bindings[2] = r.id();
+    dispatch.bindings[5] = r.id();
+    check("undeclared binding",
+        expect_error(ctx, dispatch, "binding 5 is not declared"));
+
+    // Shared memory that can shrink under the daemon's mapping is refused.
+    int fd = memfd_create("gcl", MFD_CLOEXEC);
+    bool sized = fd >= 0
+        && ftruncate(fd, static_cast<off_t>(ctx.get_alignment())) == 0;
+
+    gcl::remote::Request create;
+    create.op = gcl::remote::Op::CreateBuffer;
+    create.size = sizeof(float);
+    check("unsealed shared memory", sized
+        && expect_error(ctx, create, "sealed with F_SEAL_SHRINK", fd));
+
+    if (fd >= 0)
+        close(fd);
+
+    // The sealed memory of a buffer can't be shrunk by the client either.
+    gcl::SharedMemory sealed(ctx.get_alignment());
+    check("shrinking sealed memory",
+        ftruncate(sealed.fd(), 0) != 0 && errno == EPERM);
+
+    // The daemon still serves the client after all of the above.
+    k.bind(0, a);
+    k.bind(1, b);
+    k.bind(2, r);
+    k.dispatch(N);
+
+    bool correct = true;
+    for (float v : r.fetch())
+        correct = correct && v == 7.f;
+
+    check("dispatch after errors", correct);
+
+    return g_failures == 0 ? 0 : 1;
+}
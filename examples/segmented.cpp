@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/Embedded.h"
+#include "../include/GCLContext.h"
+#include "../include/Kernel.h"
+#include "../include/Segmented.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/// Runs |fn| |iterations| times and returns the mean time in microseconds.
+template<typename Fn>
+static double time_us(uint32_t iterations, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+        fn();
+
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc != 5) {
+        std::cout << "usage: ./segmented <arrays> <min size> <max size> "
+            "<iterations>" << std::endl;
+        return 1;
+    }
+
+    const uint32_t arrays = std::stoul(argv[1]);
+    const uint32_t min_size = std::stoul(argv[2]);
+    const uint32_t max_size = std::stoul(argv[3]);
+    const uint32_t iterations = std::stoul(argv[4]);
+
+    gcl::GCLContext ctx(gcl::Backend::Device);
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<uint32_t> length(min_size, max_size);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+
+    std::vector<uint32_t> sizes(arrays);
+    std::vector<std::vector<float>> va(arrays), vb(arrays);
+    for (uint32_t i = 0; i < arrays; ++i) {
+        sizes[i] = length(rng);
+        va[i].resize(sizes[i]);
+        vb[i].resize(sizes[i]);
+        for (uint32_t j = 0; j < sizes[i]; ++j) {
+            va[i][j] = uniform(rng);
+            vb[i][j] = uniform(rng);
+        }
+    }
+
+    // One dispatch per array. The ma kernel has no bounds check, so the
+    // buffers are padded to whole workgroups.
+    gcl::Kernel ma(ctx, gcl::embedded::ma);
+    const uint32_t local_size = ma.get_local_size_x();
+
+    std::vector<std::unique_ptr<gcl::Buffer<float>>> a, b, res;
+    for (uint32_t i = 0; i < arrays; ++i) {
+        uint64_t padded = (sizes[i] + local_size) / local_size * local_size;
+        a.push_back(std::make_unique<gcl::Buffer<float>>(ctx, padded));
+        b.push_back(std::make_unique<gcl::Buffer<float>>(ctx, padded));
+        res.push_back(std::make_unique<gcl::Buffer<float>>(ctx, padded));
+        a[i]->send(va[i]);
+        b[i]->send(vb[i]);
+    }
+
+    double single_us = time_us(iterations, [&]() {
+        for (uint32_t i = 0; i < arrays; ++i) {
+            ma.bind(0, *a[i]);
+            ma.bind(1, *b[i]);
+            ma.bind(2, *res[i]);
+            ma.dispatch(static_cast<int32_t>(sizes[i]));
+        }
+    });
+
+    // One dispatch for the whole batch.
+    gcl::SegmentedBatch sa(ctx, sizes), sb(ctx, sizes), sres(ctx, sizes);
+    sa.send(va);
+    sb.send(vb);
+
+    gcl::SegmentedOps ops(ctx);
+    double batch_us = time_us(iterations, [&]() { ops.ma(sa, sb, sres); });
+
+    std::vector<float> sums;
+    double reduce_us = time_us(iterations, [&]() {
+        sums = ops.reduce(sres, gcl::SegmentOp::Sum);
+    });
+
+    std::vector<std::vector<float>> batched = sres.fetch();
+
+    uint32_t mismatches = 0;
+    double sum_error = 0.0;
+    for (uint32_t i = 0; i < arrays; ++i) {
+        std::vector<float> single = res[i]->fetch();
+
+        double expected = 0.0;
+        for (uint32_t j = 0; j < sizes[i]; ++j) {
+            mismatches += std::abs(single[j] - batched[i][j]) > 1e-6f;
+            expected += batched[i][j];
+        }
+
+        sum_error = std::max(sum_error,
+            std::abs(sums[i] - expected) / (1.0 + std::abs(expected)));
+    }
+
+    std::cout << "per-array ma: " << single_us << " us\n";
+    std::cout << "batched ma:   " << batch_us << " us\n";
+    std::cout << "batched sum:  " << reduce_us << " us\n";
+    std::cout << "mismatched elements: " << mismatches
+        << "  max sum error: " << sum_error << '\n';
+
+    return mismatches == 0 ? 0 : 1;
+}
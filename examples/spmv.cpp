@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/GCLContext.h"
+#include "../include/Sparse.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/// Generates a |rows| x |rows| matrix whose row lengths follow a power law
+/// with exponent |alpha| and mean of about |mean|, with uniformly random
+/// columns. Smaller |alpha| gives a more skewed distribution.
+static gcl::CsrMatrix power_law(uint32_t rows, double mean, double alpha) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<uint32_t> column(0, rows - 1);
+
+    // The minimum of a Pareto distribution with the requested mean.
+    double min_length = mean * (alpha - 1.0) / alpha;
+
+    std::vector<uint32_t> r, c;
+    std::vector<float> v;
+    for (uint32_t row = 0; row < rows; ++row) {
+        double length = min_length / std::pow(1.0 - uniform(rng), 1.0 / alpha);
+        uint32_t n = static_cast<uint32_t>(
+            std::clamp(length, 1.0, static_cast<double>(rows)));
+
+        for (uint32_t k = 0; k < n; ++k) {
+            r.push_back(row);
+            c.push_back(column(rng));
+            v.push_back(static_cast<float>(uniform(rng)));
+        }
+    }
+
+    return gcl::CsrMatrix::from_coo(rows, rows, r, c, v);
+}
+
+/// Returns the largest difference between |a| and |b|, relative to |b|.
+static double max_error(const std::vector<float>& a,
+                        const std::vector<float>& b) {
+    double error = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        error = std::max(error,
+            std::abs(double(a[i]) - b[i]) / (1.0 + std::abs(double(b[i]))));
+    }
+
+    return error;
+}
+
+/// Runs |fn| |iterations| times and returns the mean time in microseconds.
+template<typename Fn>
+static double time_us(uint32_t iterations, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+        fn();
+
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc < 4 || argc > 5) {
+        std::cout << "usage: ./spmv <rows> <mean row length> <iterations> "
+            "[alpha]" << std::endl;
+        return 1;
+    }
+
+    const uint32_t rows = std::stoul(argv[1]);
+    const double mean = std::stod(argv[2]);
+    const uint32_t iterations = std::stoul(argv[3]);
+    const double alpha = argc == 5 ? std::stod(argv[4]) : 1.5;
+
+    gcl::GCLContext ctx(gcl::Backend::Device);
+
+    gcl::CsrMatrix csr = power_law(rows, mean, alpha);
+    double gflop = 2.0 * csr.nnz() / 1e9;
+
+    uint32_t longest = 0;
+    for (uint32_t row = 0; row < rows; ++row)
+        longest = std::max(longest, csr.row_ptr[row + 1] - csr.row_ptr[row]);
+
+    std::cout << "nnz: " << csr.nnz() << "  longest row: " << longest << '\n';
+
+    std::vector<float> vx(rows);
+    for (uint32_t i = 0; i < rows; ++i)
+        vx[i] = float(i % 1000) / 1000.f;
+
+    gcl::Buffer<float> x(ctx, rows);
+    gcl::Buffer<float> y(ctx, rows);
+    x.send(vx);
+
+    std::vector<float> expected(rows);
+    double host_us = time_us(iterations, [&]() {
+        gcl::spmv(csr, vx.data(), expected.data());
+    });
+
+    gcl::CsrSpmv csr_spmv(ctx, csr);
+    csr_spmv.multiply(x, y);
+
+    double csr_us = time_us(iterations, [&]() { csr_spmv.multiply(x, y); });
+    double csr_error = max_error(y.fetch(), expected);
+
+    std::cout << "bins: scalar " << csr_spmv.get_bin_rows(gcl::RowBin::Scalar)
+        << ", vector " << csr_spmv.get_bin_rows(gcl::RowBin::Vector)
+        << ", block " << csr_spmv.get_bin_rows(gcl::RowBin::Block) << '\n';
+
+    std::cout << "host:  " << host_us << " us  "
+        << gflop / (host_us * 1e-6) << " GFLOP/s\n";
+    std::cout << "csr:   " << csr_us << " us  "
+        << gflop / (csr_us * 1e-6) << " GFLOP/s  max error " << csr_error
+        << '\n';
+
+    // ELL pads every row to the longest one, which is hopeless for skewed
+    // matrices, so only try it when the padding is moderate.
+    uint64_t ell_size = static_cast<uint64_t>(longest) * rows;
+    if (ell_size > 4 * csr.nnz()) {
+        std::cout << "ell:   skipped, " << ell_size / csr.nnz()
+            << "x padding\n";
+        return 0;
+    }
+
+    gcl::EllSpmv ell_spmv(ctx, gcl::EllMatrix::from_csr(csr));
+    ell_spmv.multiply(x, y);
+
+    double ell_us = time_us(iterations, [&]() { ell_spmv.multiply(x, y); });
+    double ell_error = max_error(y.fetch(), expected);
+
+    std::cout << "ell:   " << ell_us << " us  "
+        << gflop / (ell_us * 1e-6) << " GFLOP/s  max error " << ell_error
+        << '\n';
+
+    return 0;
+}
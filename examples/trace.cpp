@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/GCLContext.h"
+#include "../include/Kernel.h"
+#include "../include/Trace.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc != 3) {
+        std::cout << "usage: ./trace <N> <output.json>" << std::endl;
+        return 1;
+    }
+
+    gcl::trace::set_enabled(true);
+    gcl::trace::set_tracing(true);
+
+    gcl::GCLContext ctx;
+    const uint32_t N = std::stoul(argv[1]);
+
+    gcl::Buffer<float> a(ctx, N);
+    gcl::Buffer<float> b(ctx, N);
+    gcl::Buffer<float> r(ctx, N);
+
+    a.send(std::vector<float>(N, 1.f));
+    b.send(std::vector<float>(N, 2.f));
+
+    gcl::Kernel k(ctx, gcl::embedded::ma);
+    k.bind(0, a);
+    k.bind(1, b);
+    k.bind(2, r);
+
+    for (uint32_t i = 0; i < 16; ++i)
+        k.dispatch(N);
+
+    r.fetch();
+
+    gcl::trace::Counters counters = gcl::trace::snapshot();
+    for (uint32_t idx = 0; idx < gcl::trace::NUM_COUNTERS; ++idx) {
+        auto counter = static_cast<gcl::trace::Counter>(idx);
+        std::cout << gcl::trace::to_string(counter) << ": " 
+            << counters[counter] << '\n';
+    }
+
+    if (!gcl::trace::write_chrome_trace(argv[2])) {
+        std::cout << "failed to write trace: " << argv[2] << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_ASYNC_H_
+#define GCL_ASYNC_H_
+
+#include "Buffer.h"
+#include "Completion.h"
+#include "Kernel.h"
+#include "Program.h"
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gcl {
+
+class Reactor;
+
+/// A coroutine driven by a Reactor. It starts running when spawned on a
+/// reactor, and is destroyed when it returns.
+class Task final {
+public:
+    struct promise_type {
+        Reactor* reactor = nullptr;
+
+        Task get_return_object() {
+            return Task(
+                std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+
+        void return_void();
+        void unhandled_exception();
+    };
+
+    Task(Task&& other) noexcept
+            : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    ~Task() {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    Task(const Task&) = delete;
+    void operator=(const Task&) = delete;
+    void operator=(Task&&) = delete;
+
+private:
+    friend class Reactor;
+
+    std::coroutine_handle<promise_type> m_handle;
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+            : m_handle(handle) {}
+};
+
+/// A single-threaded event loop over epoll that resumes tasks when the file
+/// descriptors they wait on become readable. A single reactor can drive any
+/// number of concurrent device submissions without blocking a thread on
+/// each one.
+class Reactor final {
+    friend struct Task::promise_type;
+
+    int m_epoll = -1;
+
+    /// The number of spawned tasks that have not returned yet.
+    uint64_t m_tasks = 0;
+
+    /// The task waiting on each watched descriptor.
+    std::unordered_map<int, std::coroutine_handle<>> m_watched;
+
+    /// The first exception that escaped a task.
+    std::exception_ptr m_error;
+
+public:
+    Reactor();
+
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    void operator=(const Reactor&) = delete;
+
+    /// Start running |task| on this reactor. It runs until its first
+    /// suspension before this returns.
+    void spawn(Task task);
+
+    /// Resume |handle| once |fd| is readable.
+    void watch(int fd, std::coroutine_handle<> handle);
+
+    /// Wait up to |timeout| milliseconds, or indefinitely if negative, for
+    /// watched descriptors to become readable and resume their tasks.
+    /// Returns the number of tasks resumed.
+    uint32_t poll(int timeout);
+
+    /// Run until every spawned task has returned. Rethrows the first
+    /// exception that escaped a task.
+    void run();
+
+    /// Returns the number of spawned tasks that have not returned yet.
+    uint64_t get_task_count() const { return m_tasks; }
+
+    /// Returns the epoll descriptor of this reactor, which is readable
+    /// whenever poll() would resume a task, to nest it in another event loop.
+    int fd() const { return m_epoll; }
+};
+
+/// Suspends the awaiting task until a completion has finished.
+class CompletionAwaitable final {
+    Reactor& m_reactor;
+    Completion m_completion;
+
+public:
+    CompletionAwaitable(Reactor& reactor, Completion&& completion)
+            : m_reactor(reactor), m_completion(std::move(completion)) {}
+
+    bool await_ready() { return m_completion.ready(); }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        m_reactor.watch(m_completion.fd(), handle);
+    }
+
+    /// The descriptor is readable by now, so this doesn't block.
+    void await_resume() { m_completion.wait(); }
+};
+
+/// Dispatch |kernel| over |xelements| invocations and suspend the awaiting
+/// task until it has finished.
+inline CompletionAwaitable async_dispatch(Reactor& reactor, Kernel& kernel,
+                                          int32_t xelements,
+                                          int32_t ygroups = 1,
+                                          int32_t zgroups = 1) {
+    return CompletionAwaitable(
+        reactor, kernel.dispatch_async(xelements, ygroups, zgroups));
+}
+
+/// Run |program| and suspend the awaiting task until it has finished.
+inline CompletionAwaitable async_run(Reactor& reactor, Program& program) {
+    return CompletionAwaitable(reactor, program.run_async());
+}
+
+/// Suspend the awaiting task until |completion| has finished.
+inline CompletionAwaitable async_wait(Reactor& reactor,
+                                      Completion&& completion) {
+    return CompletionAwaitable(reactor, std::move(completion));
+}
+
+/// Copies |data| into a buffer when awaited. Buffers are host-visible, so
+/// the copy never waits on the device and the awaiting task isn't suspended.
+template<typename T>
+class SendAwaitable final {
+    Buffer<T>& m_buf;
+    const std::vector<T>& m_data;
+
+public:
+    SendAwaitable(Buffer<T>& buf, const std::vector<T>& data)
+            : m_buf(buf), m_data(data) {}
+
+    bool await_ready() const noexcept { return true; }
+    void await_suspend(std::coroutine_handle<>) const noexcept {}
+    void await_resume() { m_buf.send(m_data); }
+};
+
+/// Copies the contents of a buffer out when awaited, without suspending.
+/// Await the dispatches that write the buffer first.
+template<typename T>
+class FetchAwaitable final {
+    Buffer<T>& m_buf;
+
+public:
+    explicit FetchAwaitable(Buffer<T>& buf) : m_buf(buf) {}
+
+    bool await_ready() const noexcept { return true; }
+    void await_suspend(std::coroutine_handle<>) const noexcept {}
+    std::vector<T> await_resume() { return m_buf.fetch(); }
+};
+
+/// Send |data| to |buf| from a task.
+template<typename T>
+SendAwaitable<T> async_send(Buffer<T>& buf, const std::vector<T>& data) {
+    return SendAwaitable<T>(buf, data);
+}
+
+/// Fetch the contents of |buf| from a task.
+template<typename T>
+FetchAwaitable<T> async_fetch(Buffer<T>& buf) {
+    return FetchAwaitable<T>(buf);
+}
+
+} // namespace gcl
+
+#endif // GCL_ASYNC_H_
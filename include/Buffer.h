@@ -6,45 +6,138 @@
 #ifndef GCL_BUFFER_H_
 #define GCL_BUFFER_H_
 
+#include "Capture.h"
 #include "GCLContext.h"
+#include "Trace.h"
 
 #include <vulkan/vulkan.h>
 
+#include <atomic>
 #include <cstdint>
+#include <new>
 #include <vector>
 
 namespace gcl {
 
+namespace detail {
+
+/// Returns an id for a new buffer, which is never reused in the process,
+/// unlike buffer addresses and Vulkan handles.
+inline uint64_t next_buffer_id() {
+    static std::atomic<uint64_t> next_id = 1;
+    return next_id++;
+}
+
+} // namespace detail
+
 template<typename T>
 class Buffer final {
     GCLContext& m_context;
 
+    /// Identifies this buffer for as long as the process runs.
+    uint64_t m_id = detail::next_buffer_id();
+
     /// The underlying Vulkan buffer.
     VkBuffer m_buf;
 
     /// The size of this buffer in bytes. This is determined by the size of
-    /// the template parameter and the # of elements designated in the ctor.
+    /// the template parameter and the # of elements designated in the ctor,
+    /// rounded up to whole 32-bit words so that kernels can access buffers
+    /// of 8 and 16-bit types a word at a time.
     VkDeviceSize m_size;
 
+    /// The number of elements designated in the ctor.
+    uint64_t m_elements;
+
     /// The corresponding VMA device memory allocation.
-    VmaAllocation m_alloc;
+    VmaAllocation m_alloc = nullptr;
+
+    /// The backing memory of this buffer if the context runs on the host.
+    void* m_host = nullptr;
+
+    /// If true, this buffer was spilled to host memory because device memory
+    /// was under pressure.
+    bool m_spilled = false;
+
+    /// If true, this buffer wraps host memory that it doesn't own.
+    bool m_wrapped = false;
+
+    /// The imported device memory of a buffer that wraps host memory.
+    VkDeviceMemory m_memory = nullptr;
+
+    /// Alignment of host backing memory, wide enough for any vector load.
+    static constexpr std::align_val_t HOST_ALIGNMENT { 64 };
 
 public:
     Buffer(GCLContext& context, uint64_t N) 
-            : m_context(context), m_size(sizeof(T) * N) {
+            : m_context(context), 
+              m_buf(nullptr), 
+              m_size((sizeof(T) * N + 3) & ~VkDeviceSize(3)), 
+              m_elements(N) {
+        capture::create_buffer(this, m_size);
+
+        if (m_context.is_host()) {
+            m_host = ::operator new(m_size, HOST_ALIGNMENT);
+            return;
+        }
+
         VkBufferCreateInfo buf_info {};
         buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        buf_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        buf_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT 
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
         buf_info.size = m_size;
 
-        VmaAllocationCreateInfo alloc_info {};
-        alloc_info.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+        m_spilled = m_context.create_buffer(buf_info, &m_buf, &m_alloc);
+    }
+
+    /// Wrap |N| elements of existing host memory at |host| without copying
+    /// them. The memory must outlive this buffer. On device contexts it is
+    /// imported into the device, so it must satisfy the alignment described
+    /// at GCLContext::import_host_memory().
+    Buffer(GCLContext& context, void* host, uint64_t N)
+            : m_context(context),
+              m_buf(nullptr),
+              m_size((sizeof(T) * N + 3) & ~VkDeviceSize(3)),
+              m_elements(N),
+              m_host(host),
+              m_wrapped(true) {
+        capture::create_buffer(this, m_size);
+
+        if (m_context.is_host())
+            return;
+
+        VkBufferCreateInfo buf_info {};
+        buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buf_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT 
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+        buf_info.size = m_size;
 
-        VK_CHECK(vmaCreateBuffer(
-            m_context, &buf_info, &alloc_info, &m_buf, &m_alloc, nullptr));
+        m_context.import_host_memory(m_host, buf_info, &m_buf, &m_memory);
     }
 
     ~Buffer() {
+        capture::record(capture::Record::Type::DestroyBuffer, this);
+
+        if (m_wrapped) {
+            if (m_buf != nullptr)
+                vkDestroyBuffer(m_context, m_buf, nullptr);
+
+            if (m_memory != nullptr)
+                vkFreeMemory(m_context, m_memory, nullptr);
+
+            m_buf = nullptr;
+            m_memory = nullptr;
+            return;
+        }
+
+        if (m_host != nullptr) {
+            ::operator delete(m_host, HOST_ALIGNMENT);
+            m_host = nullptr;
+            return;
+        }
+
         vmaDestroyBuffer(m_context, m_buf, m_alloc);
 
         m_buf = nullptr;
@@ -59,16 +152,33 @@ public:
 
     operator VkBuffer() const { return m_buf; }
 
+    /// Returns the id of this buffer, which no other buffer of the process
+    /// ever has, so it can key caches that outlive the buffer.
+    uint64_t id() const { return m_id; }
+
+    /// Returns the VMA allocation of this buffer, or nullptr if the context 
+    /// runs on the host.
+    VmaAllocation allocation() const { return m_alloc; }
+
+    /// Returns the backing memory of this buffer if the context runs on the 
+    /// host or the buffer wraps host memory, and nullptr otherwise.
+    void* host_data() const { return m_host; }
+
+    /// Returns true if this buffer was spilled to host memory because device
+    /// memory was under pressure.
+    bool spilled() const { return m_spilled; }
+
     /// Returns the size of this buffer in bytes.
     uint64_t size() const { return static_cast<uint64_t>(m_size); }
 
-    /// Returns the number of elements which can fit into this buffer based on
-    /// the template type.
-    uint64_t elements() const { 
-        return static_cast<uint64_t>(m_size) / sizeof(T); 
-    }
+    /// Returns the number of elements in this buffer.
+    uint64_t elements() const { return m_elements; }
 
     void send(const std::vector<T>& data) const {
+        GCL_SCOPE("Buffer::send");
+        GCL_COUNT(BytesUploaded, data.size() * sizeof(T));
+        capture::send(this, data.data(), data.size() * sizeof(T));
+
         void* p = nullptr;
         map(&p);
 
@@ -80,6 +190,10 @@ public:
     }
 
     std::vector<T> fetch() const {
+        GCL_SCOPE("Buffer::fetch");
+        GCL_COUNT(BytesDownloaded, m_size);
+        capture::record(capture::Record::Type::Fetch, this);
+
         invalidate();
 
         void* p = nullptr;
@@ -94,20 +208,34 @@ public:
     }
 
     void map(void** out) const {
+        if (m_host != nullptr) {
+            *out = m_host;
+            return;
+        }
+
         void* data;
         vmaMapMemory(m_context, m_alloc, &data);
         *out = reinterpret_cast<void*>(data);
     }
 
     void unmap() const {
+        if (m_host != nullptr)
+            return;
+
         vmaUnmapMemory(m_context, m_alloc);
     }
 
     void flush() const {
+        if (m_host != nullptr)
+            return;
+
         vmaFlushAllocation(m_context, m_alloc, 0, VK_WHOLE_SIZE);
     }
 
     void invalidate() const {
+        if (m_host != nullptr)
+            return;
+
         vmaInvalidateAllocation(m_context, m_alloc, 0, VK_WHOLE_SIZE);
     }
 };
@@ -0,0 +1,225 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_CAPTURE_H_
+#define GCL_CAPTURE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/// Capture of the stream of buffer and kernel calls to a file, so that it can
+/// be replayed elsewhere with tools/gcl_replay.
+///
+/// A capture file starts with MAGIC and VERSION, followed by records that
+/// each start with their Record::Type as a uint32_t. Buffers and kernels are
+/// identified by their address in the capturing process, which may be reused
+/// after they are destroyed. Buffers and kernels created before the capture
+/// started are unknown to it, so captures are best started on startup by 
+/// setting GCL_CAPTURE.
+namespace gcl::capture {
+
+inline constexpr char MAGIC[8] = { 'G', 'C', 'L', 'C', 'A', 'P', '\0', '\0' };
+inline constexpr uint32_t VERSION = 1;
+
+/// A single captured call.
+struct Record {
+    enum class Type : uint32_t {
+        /// |id| was created with |size| bytes.
+        CreateBuffer = 1,
+
+        /// |id| was destroyed.
+        DestroyBuffer,
+
+        /// |id| was created as the kernel |name| from the SPIR-V in |data|.
+        CreateKernel,
+
+        /// |id| was destroyed.
+        DestroyKernel,
+
+        /// The buffer |target| was bound to |binding| of the kernel |id|.
+        Bind,
+
+        /// The push constants of the kernel |id| were set to |data|.
+        Push,
+
+        /// |size| bytes were sent to the buffer |id|. |data| holds them if
+        /// contents are captured, and is empty otherwise.
+        Send,
+
+        /// The buffer |id| was fetched.
+        Fetch,
+
+        /// The kernel |id| was dispatched over |x| invocations and |y| by 
+        /// |z| groups.
+        Dispatch,
+
+        /// The kernel |id| was dispatched with the group counts at byte 
+        /// |size| of the buffer |target|.
+        DispatchIndirect,
+
+        /// The dispatches up to the next EndProgram were run as a Program,
+        /// in a single submission.
+        BeginProgram,
+        EndProgram,
+    };
+
+    Type type = Type::CreateBuffer;
+    uint64_t id = 0;
+    uint64_t target = 0;
+    uint64_t size = 0;
+    uint32_t binding = 0;
+    uint32_t x = 0;
+    uint32_t y = 1;
+    uint32_t z = 1;
+    std::string name;
+    std::vector<uint8_t> data;
+};
+
+/// Returns a printable name for |type|.
+const char* to_string(Record::Type type);
+
+namespace detail {
+
+/// If true, calls are being captured.
+extern std::atomic<bool> g_active;
+
+/// Append |record| to the capture file.
+void write(const Record& record);
+
+void create_kernel(const void* id, const std::string& name,
+                   const uint32_t* spirv, uint64_t words);
+
+void push(const void* id, const void* data, uint32_t size);
+
+void send(const void* id, const void* data, uint64_t size);
+
+} // namespace detail
+
+/// Returns true if calls are being captured.
+inline bool is_active() {
+    return detail::g_active.load(std::memory_order_relaxed);
+}
+
+/// Start capturing to |path|, with the contents of sent buffers if 
+/// |contents| is true. Started on startup if the GCL_CAPTURE environment
+/// variable holds a path, and with contents if GCL_CAPTURE_CONTENTS is set
+/// too. Returns false if the file can't be written.
+bool start(const std::string& path, bool contents = false);
+
+/// Stop capturing and close the capture file.
+void stop();
+
+/// Capture |type| for the object |id|, if capturing.
+inline void record(Record::Type type, const void* id) {
+    if (!is_active())
+        return;
+
+    Record record;
+    record.type = type;
+    record.id = reinterpret_cast<uintptr_t>(id);
+    detail::write(record);
+}
+
+/// Capture the creation of the buffer |id| of |size| bytes, if capturing.
+inline void create_buffer(const void* id, uint64_t size) {
+    if (!is_active())
+        return;
+
+    Record record;
+    record.type = Record::Type::CreateBuffer;
+    record.id = reinterpret_cast<uintptr_t>(id);
+    record.size = size;
+    detail::write(record);
+}
+
+/// Capture the creation of the kernel |id| called |name| from the |words|
+/// words of SPIR-V at |spirv|, if capturing.
+inline void create_kernel(const void* id, const std::string& name, 
+                          const uint32_t* spirv, uint64_t words) {
+    if (is_active())
+        detail::create_kernel(id, name, spirv, words);
+}
+
+/// Capture the binding of the buffer |buffer| to |binding| of the kernel
+/// |id|, if capturing.
+inline void bind(const void* id, uint32_t binding, const void* buffer) {
+    if (!is_active())
+        return;
+
+    Record record;
+    record.type = Record::Type::Bind;
+    record.id = reinterpret_cast<uintptr_t>(id);
+    record.target = reinterpret_cast<uintptr_t>(buffer);
+    record.binding = binding;
+    detail::write(record);
+}
+
+/// Capture the |size| bytes at |data| as push constants of the kernel |id|,
+/// if capturing.
+inline void push(const void* id, const void* data, uint32_t size) {
+    if (is_active())
+        detail::push(id, data, size);
+}
+
+/// Capture |size| bytes at |data| being sent to the buffer |id|, if 
+/// capturing.
+inline void send(const void* id, const void* data, uint64_t size) {
+    if (is_active())
+        detail::send(id, data, size);
+}
+
+/// Capture a dispatch of the kernel |id|, if capturing.
+inline void dispatch(const void* id, uint32_t x, uint32_t y, uint32_t z) {
+    if (!is_active())
+        return;
+
+    Record record;
+    record.type = Record::Type::Dispatch;
+    record.id = reinterpret_cast<uintptr_t>(id);
+    record.x = x;
+    record.y = y;
+    record.z = z;
+    detail::write(record);
+}
+
+/// Capture an indirect dispatch of the kernel |id| with the group counts at
+/// byte |offset| of the buffer |args|, if capturing.
+inline void dispatch_indirect(const void* id, const void* args, 
+                              uint64_t offset) {
+    if (!is_active())
+        return;
+
+    Record record;
+    record.type = Record::Type::DispatchIndirect;
+    record.id = reinterpret_cast<uintptr_t>(id);
+    record.target = reinterpret_cast<uintptr_t>(args);
+    record.size = offset;
+    detail::write(record);
+}
+
+/// Reads the records of a capture file in order.
+class Reader final {
+    std::FILE* m_file = nullptr;
+
+public:
+    /// Open the capture file at |path|. Throws if it isn't one.
+    explicit Reader(const std::string& path);
+
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    void operator=(const Reader&) = delete;
+
+    /// Read the next record into |record|. Returns false at the end of the
+    /// file, and throws if the file is truncated or corrupt.
+    bool next(Record& record);
+};
+
+} // namespace gcl::capture
+
+#endif // GCL_CAPTURE_H_
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_COMPLETION_H_
+#define GCL_COMPLETION_H_
+
+#include <vulkan/vulkan.h>
+
+namespace gcl {
+
+class GCLContext;
+
+/// The completion of an asynchronous submission, observable through a file
+/// descriptor that becomes readable once the submission has finished. The
+/// descriptor can be added to poll, epoll or any other event loop, so that
+/// no thread has to block waiting for the device.
+///
+/// Destroying a completion that has not finished waits for it, and reports
+/// rather than throws any error waiting.
+class Completion final {
+    GCLContext* m_context = nullptr;
+
+    /// The pool |m_cmd| was taken from, or nullptr if the command buffer is
+    /// owned by someone else.
+    VkCommandPool m_pool = nullptr;
+    VkCommandBuffer m_cmd = nullptr;
+    VkFence m_fence = nullptr;
+
+    int m_fd = -1;
+
+    /// If true, the fence payload was exported to |m_fd| as a sync file,
+    /// which leaves the fence itself unsignaled.
+    bool m_exported = false;
+
+    bool m_done = false;
+
+    /// Return the fence and command buffer to the context.
+    void finish();
+
+    /// Wait for the submission without throwing, for the destructor and move
+    /// assignment. If waiting fails, the fence and command buffer may still
+    /// be in use and are leaked rather than returned to the context.
+    void wait_or_abandon() noexcept;
+
+public:
+    /// Creates a completion that has already finished, for work that ran
+    /// synchronously on the host.
+    Completion();
+
+    Completion(GCLContext* context, VkCommandPool pool, VkCommandBuffer cmd,
+               VkFence fence, int fd, bool exported);
+
+    ~Completion();
+
+    Completion(const Completion&) = delete;
+    void operator=(const Completion&) = delete;
+
+    Completion(Completion&& other) noexcept;
+    Completion& operator=(Completion&& other) noexcept;
+
+    /// Returns a file descriptor that is readable once the submission has
+    /// finished. The descriptor is owned by this completion.
+    int fd() const { return m_fd; }
+
+    /// Returns true if the submission has finished, without blocking.
+    bool ready();
+
+    /// Block until the submission has finished.
+    void wait();
+};
+
+} // namespace gcl
+
+#endif // GCL_COMPLETION_H_
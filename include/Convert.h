@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_CONVERT_H_
+#define GCL_CONVERT_H_
+
+#include "Buffer.h"
+#include "GCLContext.h"
+#include "Kernel.h"
+#include "Types.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace gcl {
+
+/// Converts between reduced-precision storage buffers and 32-bit float 
+/// buffers on the device, so that data can be transferred and kept in 
+/// device memory at 2-4x less size while kernels compute in fp32.
+///
+/// Uses 16 and 8-bit storage access when the device supports it, and kernels
+/// that work on packed 32-bit words otherwise. On host contexts, converts on
+/// the host.
+class Converter final {
+    GCLContext& m_context;
+
+    /// The directory the conversion kernels are loaded from, or empty to use
+    /// the kernels embedded into the library.
+    std::string m_dir;
+
+    /// Conversion kernels, created on first use.
+    std::unordered_map<std::string, std::unique_ptr<Kernel>> m_kernels;
+
+    /// Returns the conversion kernel called |name|, creating it if needed.
+    Kernel& get_kernel(const std::string& name);
+
+    /// Run the conversion kernel |name| from |in| to |out| over |n| 
+    /// elements, that are packed |per_word| to a word if not |native|.
+    template<typename In, typename Out>
+    void convert(const std::string& name, bool native, uint32_t per_word,
+                 Buffer<In>& in, Buffer<Out>& out, uint64_t n, float scale);
+
+public:
+    Converter(GCLContext& context, const std::string& dir = "");
+
+    Converter(const Converter&) = delete;
+    void operator=(const Converter&) = delete;
+
+    Converter(Converter&&) = delete;
+    void operator=(Converter&&) = delete;
+
+    /// Expand the binary16 values of |in| to floats in |out|.
+    void expand(Buffer<half>& in, Buffer<float>& out);
+
+    /// Pack the floats of |in| to binary16 values in |out|.
+    void pack(Buffer<float>& in, Buffer<half>& out);
+
+    /// Expand the bfloat16 values of |in| to floats in |out|.
+    void expand(Buffer<bfloat16>& in, Buffer<float>& out);
+
+    /// Pack the floats of |in| to bfloat16 values in |out|.
+    void pack(Buffer<float>& in, Buffer<bfloat16>& out);
+
+    /// Dequantize the 8-bit values of |in| to floats in |out| as 
+    /// q * |scale|.
+    void expand(Buffer<int8_t>& in, Buffer<float>& out, float scale);
+
+    /// Quantize the floats of |in| to 8-bit values in |out| as 
+    /// round(x / |scale|), clamped to [-127, 127].
+    void pack(Buffer<float>& in, Buffer<int8_t>& out, float scale);
+};
+
+} // namespace gcl
+
+#endif // GCL_CONVERT_H_
@@ -0,0 +1,32 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_EMBEDDED_H_
+#define GCL_EMBEDDED_H_
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace gcl::embedded {
+
+/// The SPIR-V of a kernel in kernels/, compiled and embedded into the library
+/// when it was built.
+struct Spirv {
+    /// The name of the kernel, its file name without extension.
+    const char* name;
+
+    std::span<const uint32_t> code;
+};
+
+/// Returns the embedded kernel called |name|, or nullptr if there is none.
+const Spirv* find(const std::string& name);
+
+} // namespace gcl::embedded
+
+// Defines an inline constexpr Spirv per kernel, e.g. gcl::embedded::ma.
+#include "EmbeddedKernels.h"
+
+#endif // GCL_EMBEDDED_H_
@@ -7,11 +7,21 @@
 #define GCL_CONTEXT_H_
 
 #include "../vendor/vma.h"
+#include "Completion.h"
+#include "Profile.h"
 
 #include <vulkan/vulkan.h>
 #include <vulkan/vk_enum_string_helper.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 using rt_error = std::runtime_error;
 
@@ -30,19 +40,154 @@ using rt_error = std::runtime_error;
 
 namespace gcl {
 
+class FenceWaiter;
+
+/// The execution backends a context can use.
+enum class Backend {
+    /// Use a Vulkan device if one is usable, otherwise fall back to the host.
+    Auto,
+
+    /// Use a Vulkan device, and fail if there is none.
+    Device,
+
+    /// Run every kernel on the host with its native implementation.
+    Host,
+};
+
+/// The budget and usage of a single device memory heap.
+struct HeapBudget {
+    /// The index of the heap.
+    uint32_t heap = 0;
+
+    /// If true, this heap is local to the device.
+    bool device_local = false;
+
+    /// The total size of the heap in bytes.
+    uint64_t size = 0;
+
+    /// The number of bytes this process can allocate from the heap. Reported
+    /// by the driver if VK_EXT_memory_budget is available, and estimated by 
+    /// VMA otherwise.
+    uint64_t budget = 0;
+
+    /// The number of bytes this process currently uses from the heap.
+    uint64_t usage = 0;
+
+    /// The number of bytes in device memory blocks allocated by the context.
+    uint64_t block_bytes = 0;
+
+    /// The number of bytes in buffers allocated by the context.
+    uint64_t allocation_bytes = 0;
+};
+
+/// Optional device features that are enabled when the device has them.
+struct DeviceFeatures {
+    /// 16-bit types can be stored in storage buffers.
+    bool storage_buffer_16bit = false;
+
+    /// 8-bit types can be stored in storage buffers.
+    bool storage_buffer_8bit = false;
+
+    /// 16-bit floats can be used in shader arithmetic.
+    bool shader_float16 = false;
+
+    /// 8-bit integers can be used in shader arithmetic.
+    bool shader_int8 = false;
+
+    /// Subgroup arithmetic operations can be used in compute shaders.
+    bool subgroup_arithmetic = false;
+
+    /// The default number of invocations in a subgroup.
+    uint32_t subgroup_size = 1;
+};
+
 class GCLContext {
     friend class Kernel;
 
+    /// Per-thread command recording state. Command pools are externally 
+    /// synchronized, so every host thread that records through this context
+    /// lazily gets its own pool and primary command buffer.
+    struct ThreadCommands {
+        VkCommandPool pool = nullptr;
+        VkCommandBuffer cmd = nullptr;
+
+        /// The index of the compute queue this thread submits to.
+        uint32_t queue = 0;
+
+        /// Command buffers of finished asynchronous submissions. Released by
+        /// any thread, but only reset and reused by the owning thread.
+        std::mutex free_lock;
+        std::vector<VkCommandBuffer> free;
+    };
+
+    /// A compute queue and the lock that guards submissions to it.
+    struct ComputeQueue {
+        VkQueue queue = nullptr;
+        std::mutex lock;
+    };
+
+    /// Unique identifier of this context, used to key thread-local caches.
+    const uint64_t m_id;
+
+    /// If true, this context has no device and kernels run on the host.
+    bool m_host = false;
+
+    /// Dispatches of fewer invocations than this run on the host when the
+    /// kernel has a host implementation.
+    std::atomic<uint64_t> m_host_threshold;
+
     VkInstance m_instance = nullptr;
     VkPhysicalDevice m_physical_device = nullptr;
     VkDevice m_device = nullptr;
-    VkQueue m_queue = nullptr;
     uint32_t m_qfamily = 0;
-    VkFence m_fence = nullptr;
-    VkCommandPool m_pool = nullptr;
-    VkCommandBuffer m_cmd = nullptr;
     VmaAllocator m_allocator = nullptr;
 
+    /// The compute queues created on the device. Threads are distributed 
+    /// over these round-robin so that they only contend with each other when
+    /// there are more threads than queues.
+    std::vector<std::unique_ptr<ComputeQueue>> m_queues;
+    std::atomic<uint32_t> m_next_queue = 0;
+
+    /// Command state for every thread that has recorded through this context.
+    std::mutex m_commands_lock;
+    std::vector<std::unique_ptr<ThreadCommands>> m_commands;
+
+    /// The optional device extensions that were enabled.
+    std::set<std::string> m_device_extensions;
+
+    /// The optional device features that were enabled.
+    DeviceFeatures m_features;
+
+    /// The fraction of a heap's budget that buffers may fill before they are
+    /// spilled to host memory instead.
+    std::atomic<double> m_soft_limit;
+
+    /// The number of buffers that have been spilled to host memory.
+    std::atomic<uint64_t> m_spilled = 0;
+
+    /// The measured characteristics of the device, if it has been profiled.
+    DeviceProfile m_profile;
+
+    /// Recycled fences, one of which is taken for each submission.
+    std::mutex m_fences_lock;
+    std::vector<VkFence> m_fences;
+    std::vector<VkFence> m_free_fences;
+
+    /// If true, fences are created exportable and asynchronous submissions
+    /// export them as sync file descriptors.
+    bool m_fence_fd = false;
+    PFN_vkGetFenceFdKHR m_get_fence_fd = nullptr;
+
+    /// The alignment of host memory imported with VK_EXT_external_memory_host,
+    /// or zero if host memory can't be imported.
+    VkDeviceSize m_import_alignment = 0;
+    PFN_vkGetMemoryHostPointerPropertiesEXT m_get_host_pointer_props = nullptr;
+
+    /// Signals the descriptors of asynchronous submissions when fences can't
+    /// be exported. Started on first use.
+    std::mutex m_waiter_lock;
+    std::unique_ptr<FenceWaiter> m_waiter;
+
 #ifdef USE_VALIDATION_LAYERS
     VkDebugUtilsMessengerEXT m_msger = nullptr;
 #endif // USE_VALIDATION_LAYERS
@@ -56,17 +201,18 @@ class GCLContext {
     /// Initialize the Vulkan logical device object for this context.
     void init_vulkan_logical_device();
 
-    /// Initialize the Vulkan sync structures for this context.
-    void init_vulkan_sync_structures();
-
-    /// Initialize the Vulkan command pool and command buffer for this context.
-    void init_vulkan_commands();
-
     /// Initialize the VMA allocator for this context.
     void init_vma_allocator();
 
+    /// Destroy all Vulkan objects created so far by this context.
+    void destroy();
+
+    /// Returns the command state of the calling thread, creating it on first
+    /// use.
+    ThreadCommands& get_thread_commands();
+
 public:
-    GCLContext();
+    GCLContext(Backend backend = Backend::Auto);
 
     ~GCLContext();
 
@@ -81,6 +227,85 @@ public:
     operator VkPhysicalDevice() const { return m_physical_device; }
     operator VmaAllocator() const { return m_allocator; }
 
+    /// Returns true if this context runs kernels on the host because it has 
+    /// no device.
+    bool is_host() const { return m_host; }
+
+    /// Returns the number of invocations under which kernels with a host
+    /// implementation are dispatched on the host instead of the device.
+    uint64_t get_host_threshold() const { return m_host_threshold.load(); }
+
+    /// Sets the number of invocations under which kernels with a host 
+    /// implementation are dispatched on the host. Zero disables routing.
+    void set_host_threshold(uint64_t threshold) { 
+        m_host_threshold.store(threshold); 
+    }
+
+    /// Returns the profile of the device, which is loaded from the profile
+    /// cache on creation if the device has been probed before.
+    const DeviceProfile& get_profile() const { return m_profile; }
+
+    /// Tunes this context from |profile|: sets the host threshold, the host
+    /// grain and the workgroup limit to the values derived from it. The host
+    /// grain is shared by every context. Must not be called while other 
+    /// threads use the context.
+    void set_profile(const DeviceProfile& profile);
+
+    /// Returns the number of workgroups of |local_size| invocations that
+    /// grid-stride kernels should dispatch at most: enough to saturate the
+    /// device if it has been profiled, capped at |limit|, and |limit|
+    /// otherwise.
+    uint32_t get_max_groups(uint32_t limit, uint32_t local_size) const {
+        if (m_profile.saturating_invocations == 0 || local_size == 0)
+            return limit;
+
+        uint64_t groups =
+            (m_profile.saturating_invocations + local_size - 1) / local_size;
+        return static_cast<uint32_t>(std::min<uint64_t>(groups, limit));
+    }
+
+    /// Returns true if the optional device extension |name| is enabled.
+    bool has_device_extension(const std::string& name) const;
+
+    /// Returns the optional device features that are enabled.
+    const DeviceFeatures& get_features() const { return m_features; }
+
+    /// Returns the budget and usage of every device memory heap.
+    std::vector<HeapBudget> get_memory_budgets() const;
+
+    /// Returns the fraction of a heap's budget that buffers may fill before
+    /// they are spilled to host memory.
+    double get_soft_limit() const { return m_soft_limit.load(); }
+
+    /// Sets the fraction of a heap's budget that buffers may fill before 
+    /// they are spilled to host memory.
+    void set_soft_limit(double fraction) { m_soft_limit.store(fraction); }
+
+    /// Returns the number of buffers that were spilled to host memory.
+    uint64_t get_spill_count() const { return m_spilled.load(); }
+
+    /// Create a host-visible buffer described by |info|. The buffer is put in
+    /// device memory unless that would take its heap over the soft limit, or
+    /// the heap is exhausted, in which case it is placed in host memory that
+    /// the device streams from. Returns true if the buffer was spilled.
+    bool create_buffer(const VkBufferCreateInfo& info, VkBuffer* buf, 
+                       VmaAllocation* alloc);
+
+    /// Returns the alignment that host memory imported into buffers must 
+    /// have, in both address and size, or zero if the device can't import
+    /// host memory.
+    VkDeviceSize get_host_import_alignment() const { 
+        return m_import_alignment; 
+    }
+
+    /// Create a buffer described by |info| over the existing host memory at
+    /// |host|, which must be aligned to get_host_import_alignment() and
+    /// extend to the next multiple of it past |info|.size, and must outlive
+    /// the buffer. The buffer and the imported memory are returned in |buf|
+    /// and |memory|, and are freed by the caller.
+    void import_host_memory(void* host, const VkBufferCreateInfo& info,
+                            VkBuffer* buf, VkDeviceMemory* memory);
+
     /// Returns the Vulkan instance used in this context.
     VkInstance get_instance() const { return m_instance; }
 
@@ -90,21 +315,54 @@ public:
     /// Returns the Vulkan physical device used in this context.
     VkPhysicalDevice get_physical_device() const { return m_physical_device; }
 
-    /// Returns the Vulkan compute queue used in this context.
-    VkQueue get_compute_queue() const { return m_queue; }
+    /// Returns the first Vulkan compute queue used in this context. Direct use
+    /// of the queue is not synchronized with submissions made through 
+    /// submit().
+    VkQueue get_compute_queue() const { return m_queues.front()->queue; }
+
+    /// Returns the number of compute queues used in this context.
+    uint32_t get_compute_queue_count() const { 
+        return static_cast<uint32_t>(m_queues.size()); 
+    }
 
     /// Returns the queue family index for the compute queue used in this 
     /// context.
     uint32_t get_compute_queue_family() const { return m_qfamily; }
 
-    /// Returns a Vulkan fence used for kernel dispatch synchronization.
-    VkFence get_fence() const { return m_fence; }
+    /// Returns the Vulkan command pool of the calling thread.
+    VkCommandPool get_command_pool() { return get_thread_commands().pool; }
+
+    /// Returns the Vulkan command buffer of the calling thread.
+    VkCommandBuffer get_command_buffer() { return get_thread_commands().cmd; }
+
+    /// Takes an unsignaled fence from this context's fence pool.
+    VkFence acquire_fence();
+
+    /// Returns an unsignaled fence to this context's fence pool.
+    void release_fence(VkFence fence);
+
+    /// Submits a recorded command buffer to the calling thread's compute
+    /// queue and blocks until it has finished executing. Safe to call from 
+    /// any number of threads at once.
+    void submit(VkCommandBuffer cmd);
+
+    /// Returns true if completions of asynchronous submissions are backed by
+    /// exported sync files rather than a waiter thread.
+    bool has_fence_fd() const { return m_fence_fd; }
+
+    /// Takes a command buffer from the calling thread's pool for recording
+    /// an asynchronous submission. It is returned to the pool when the 
+    /// submission's completion finishes.
+    VkCommandBuffer acquire_command_buffer();
 
-    /// Returns the Vulkan command pool used in this context.
-    VkCommandPool get_command_pool() const { return m_pool; }
+    /// Returns |cmd|, taken from |pool| with acquire_command_buffer(), for
+    /// reuse. Safe to call from any thread.
+    void release_command_buffer(VkCommandPool pool, VkCommandBuffer cmd);
 
-    /// Returns the Vulkan command buffer used in this context.
-    VkCommandBuffer get_command_buffer() const { return m_cmd; }
+    /// Submits a recorded command buffer to the calling thread's compute 
+    /// queue without waiting for it. If |pool| is not nullptr, |cmd| was taken
+    /// from it with acquire_command_buffer() and is released once finished.
+    Completion submit_async(VkCommandBuffer cmd, VkCommandPool pool = nullptr);
     
     /// Returns the VMA allocator used in this context.
     VmaAllocator get_allocator() const { return m_allocator; }
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_HISTOGRAM_H_
+#define GCL_HISTOGRAM_H_
+
+#include "Buffer.h"
+#include "GCLContext.h"
+#include "Kernel.h"
+#include "Program.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gcl {
+
+/// Counts the values of a buffer into bins on the device, so that only the
+/// bin counts are transferred back rather than the values.
+///
+/// Bin i counts the values in [edges[i], edges[i + 1]), and the last bin
+/// includes its upper edge. Values outside of the edges, and NaNs, aren't
+/// counted. Supported for float and uint32_t values. On host contexts,
+/// counts on the host.
+template<typename T>
+class Histogram final {
+    GCLContext& m_context;
+
+    /// The ascending bin edges, one more than there are bins.
+    std::vector<T> m_edges;
+
+    /// If true, the edges are evenly spaced.
+    bool m_uniform = false;
+
+    Buffer<T> m_edge_buf;
+    Buffer<uint32_t> m_counts;
+
+    /// The histogram kernel, on device contexts.
+    std::unique_ptr<Kernel> m_kernel;
+
+    /// A dispatch per pass over the values.
+    Program m_program;
+
+    /// Validate the edges and create the kernel.
+    void init();
+
+public:
+    /// Count into the bins between the ascending |edges|.
+    Histogram(GCLContext& context, const std::vector<T>& edges);
+
+    /// Count into |bins| evenly spaced bins over [|lo|, |hi|].
+    Histogram(GCLContext& context, T lo, T hi, uint32_t bins);
+
+    Histogram(const Histogram&) = delete;
+    void operator=(const Histogram&) = delete;
+
+    Histogram(Histogram&&) = delete;
+    void operator=(Histogram&&) = delete;
+
+    /// Returns the number of bins.
+    uint32_t get_bins() const {
+        return static_cast<uint32_t>(m_edges.size() - 1);
+    }
+
+    /// Returns the bin edges.
+    const std::vector<T>& get_edges() const { return m_edges; }
+
+    /// Returns the number of passes over the values needed to count every
+    /// bin, which is more than one if the bins don't fit in shared memory.
+    uint32_t get_passes() const;
+
+    /// Count the first |n| values of |values|, or all of them if |n| is zero,
+    /// and return the count of every bin.
+    std::vector<uint32_t> compute(Buffer<T>& values, uint64_t n = 0);
+};
+
+extern template class Histogram<float>;
+extern template class Histogram<uint32_t>;
+
+} // namespace gcl
+
+#endif // GCL_HISTOGRAM_H_
@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_HOST_H_
+#define GCL_HOST_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace gcl::host {
+
+/// Instruction set extensions that host kernels are specialized for.
+enum class Isa {
+    Scalar,
+    AVX2,
+    AVX512,
+};
+
+/// Returns the widest instruction set supported by the running CPU.
+Isa detect_isa();
+
+/// Returns a printable name for |isa|.
+const char* to_string(Isa isa);
+
+/// A host implementation of a kernel. Processes the global invocations in
+/// [begin, end), where |bindings| holds the host address of the buffer bound
+/// at each descriptor binding, indexed by binding number.
+using KernelFn = void (*)(void* const* bindings, uint64_t begin, uint64_t end);
+
+/// A registered host implementation and the buffers that it accesses.
+struct KernelImpl {
+    KernelFn fn = nullptr;
+
+    /// The number of bindings accessed, which are bindings [0, bindings).
+    uint32_t bindings = 0;
+
+    /// The number of bytes of every binding accessed by each invocation, so
+    /// that n invocations need buffers of at least n * stride bytes.
+    uint32_t stride = 0;
+};
+
+/// Registers |fn| as the host implementation of the kernel called |name|,
+/// which accesses |stride| bytes per invocation of each of its first
+/// |bindings| bindings. Only kernels created from gcl::embedded, or with
+/// |host_impl| set, look it up. The shipped kernels are registered on
+/// startup.
+void register_kernel(const std::string& name, KernelFn fn, uint32_t bindings,
+                     uint32_t stride);
+
+/// Returns the host implementation of the kernel called |name|, whose fn is
+/// nullptr if there is none.
+KernelImpl find_kernel(const std::string& name);
+
+/// Returns the number of threads used by parallel host execution, including
+/// the calling thread.
+uint32_t get_num_threads();
+
+/// Returns the minimum number of invocations given to a single thread.
+uint64_t get_grain();
+
+/// Sets the minimum number of invocations given to a single thread.
+void set_grain(uint64_t grain);
+
+/// Runs |fn| over [0, n), split into chunks of at least get_grain()
+/// invocations across the host worker threads. Blocks until all chunks are
+/// done. If the workers are busy with another call, runs on the caller only.
+void parallel_for(uint64_t n,
+                  const std::function<void(uint64_t, uint64_t)>& fn);
+
+/// Runs the host kernel |fn| over |n| invocations in parallel.
+void run(KernelFn fn, void* const* bindings, uint64_t n);
+
+/// r[i] = a[i] * b[i] + 1, as in kernels/ma.comp.
+void ma(const float* a, const float* b, float* r, uint64_t begin,
+        uint64_t end);
+
+/// The piecewise function of kernels/branch.comp.
+void branch(const float* a, const float* b, float* r, uint64_t begin,
+            uint64_t end);
+
+/// The polynomial evaluation of kernels/heavy.comp.
+void heavy(const float* a, const float* b, float* r, uint64_t begin,
+           uint64_t end);
+
+} // namespace gcl::host
+
+#endif // GCL_HOST_H_
@@ -0,0 +1,48 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_INDIRECT_H_
+#define GCL_INDIRECT_H_
+
+#include "Buffer.h"
+#include "GCLContext.h"
+#include "Kernel.h"
+
+#include <cstdint>
+#include <string>
+
+namespace gcl {
+
+/// Turns element counts produced on the device into the group counts of an 
+/// indirect dispatch, so that a kernel can be sized by the output of another
+/// without reading the count back to the host.
+class IndirectArgs final {
+    Kernel m_groups;
+
+public:
+    /// Uses the groups kernel embedded into the library.
+    IndirectArgs(GCLContext& context);
+
+    /// Uses the groups kernel from the SPIR-V file at |compute|.
+    IndirectArgs(GCLContext& context, const std::string& compute);
+
+    IndirectArgs(const IndirectArgs&) = delete;
+    void operator=(const IndirectArgs&) = delete;
+
+    IndirectArgs(IndirectArgs&&) = delete;
+    void operator=(IndirectArgs&&) = delete;
+
+    /// Write the group counts that cover as many invocations of |kernel| as
+    /// the value at |count_index| of |counts| into |args|, starting at 
+    /// element |args_index|. The result can be passed to 
+    /// Kernel::dispatch_indirect with an offset of |args_index| * 4.
+    void compute(Kernel& kernel, Buffer<uint32_t>& counts, 
+                 uint32_t count_index, Buffer<uint32_t>& args, 
+                 uint32_t args_index = 0);
+};
+
+} // namespace gcl
+
+#endif // GCL_INDIRECT_H_
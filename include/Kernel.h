@@ -7,14 +7,22 @@
 #define GCL_KERNEL_H_
 
 #include "Buffer.h"
+#include "Capture.h"
+#include "Completion.h"
+#include "Embedded.h"
 #include "GCLContext.h"
+#include "Host.h"
 
+#include <cstring>
+#include <span>
 #include <string>
 #include <vector>
 
 namespace gcl {
 
 class Kernel final {
+    friend class Program;
+
     GCLContext& m_context;
 
     VkShaderModule m_compute = nullptr;
@@ -27,14 +35,81 @@ class Kernel final {
 
     uint32_t m_local_size_x = 1;
 
-    void init_vulkan_compute_shader(const std::string& compute);
+    /// The size of the push constant block of this kernel in bytes.
+    uint32_t m_push_size = 0;
+
+    /// The push constant data recorded with each dispatch.
+    std::vector<uint8_t> m_push;
+
+    /// Incremented whenever the descriptor set of this kernel changes, which
+    /// invalidates command buffers that it was recorded into.
+    uint64_t m_generation = 0;
+
+    /// A buffer bound to this kernel, as seen by its host implementation.
+    struct HostBinding {
+        VmaAllocation alloc = nullptr;
+        void* host = nullptr;
+        uint64_t size = 0;
+    };
+
+    /// The host implementation of this kernel, whose fn is nullptr if it has
+    /// none.
+    host::KernelImpl m_host_impl;
+
+    /// The buffers bound to this kernel, indexed by binding number.
+    std::vector<HostBinding> m_host_bindings;
+
+    /// The descriptor bindings that the shader declares.
+    std::vector<uint32_t> m_bindings;
+
+    /// Look up the host implementation of the kernel |name| if |host_impl|
+    /// is true. Returns true if this is a host context, which needs no Vulkan
+    /// objects.
+    bool init_host(const std::string& name, bool host_impl);
+
+    /// Returns true if the host implementation can run |xelements|
+    /// invocations on the bound buffers without going out of bounds.
+    bool fits_host(uint64_t xelements) const;
+
+    /// Create the shader module and pipeline from |spirv|.
+    void init_vulkan(std::span<const uint32_t> spirv);
+
+    void init_vulkan_compute_shader(std::span<const uint32_t> spirv);
 
     void init_vulkan_compute_pipeline();
 
-    void reflect_descriptors(const std::vector<char>& spv);
+    void reflect_descriptors(std::span<const uint32_t> spirv);
+
+    /// Throws unless |offset| is a valid position of indirect dispatch
+    /// arguments in |args|, as vkCmdDispatchIndirect requires.
+    static void check_indirect(const Buffer<uint32_t>& args, uint64_t offset);
+
+    /// Record a barrier that makes compute shader writes from earlier 
+    /// commands visible to later dispatches and indirect argument reads.
+    static void record_barrier(VkCommandBuffer cmd);
+
+    /// Record the commands to bind the pipeline and descriptor set of this
+    /// kernel, and push constants |push|, to |cmd|.
+    void record_bind(VkCommandBuffer cmd, 
+                     const std::vector<uint8_t>& push) const;
 
 public:
-    Kernel(GCLContext& context, const std::string& compute);
+    /// Create a kernel from the SPIR-V file at |compute|. If |host_impl| is
+    /// true, the host implementation registered under the file name without
+    /// extension runs this kernel on host contexts and small dispatches, and
+    /// must compute the same as the SPIR-V.
+    Kernel(GCLContext& context, const std::string& compute,
+           bool host_impl = false);
+
+    /// Create a kernel called |name| from the SPIR-V words |spirv|, which
+    /// must stay valid for the duration of the call. If |host_impl| is true,
+    /// the host implementation registered under |name| is used as above.
+    Kernel(GCLContext& context, const std::string& name, 
+           std::span<const uint32_t> spirv, bool host_impl = false);
+
+    /// Create a kernel from SPIR-V embedded into the library, such as
+    /// embedded::ma, along with its host implementation if it has one.
+    Kernel(GCLContext& context, const embedded::Spirv& spirv);
 
     ~Kernel();
 
@@ -44,10 +119,77 @@ public:
     Kernel(Kernel&&) = delete;
     void operator=(Kernel&&) = delete;
 
+    /// Dispatch this kernel over |xelements| invocations and wait for it to
+    /// finish. Dispatches may be issued from any number of threads at once,
+    /// but a kernel must not be rebound while another thread dispatches it.
+    ///
+    /// One dimensional dispatches smaller than the context's host threshold
+    /// run on the host if this kernel has a host implementation and the bound
+    /// buffers are large enough for it.
     void dispatch(int32_t xelements, int32_t ygroups = 1, int32_t zgroups = 1);
 
+    /// Dispatch this kernel over |xelements| invocations without waiting for
+    /// it to finish. The kernel's buffers and bindings must not change until
+    /// the returned completion has finished. Dispatches routed to the host
+    /// run synchronously and return a finished completion.
+    Completion dispatch_async(int32_t xelements, int32_t ygroups = 1, 
+                              int32_t zgroups = 1);
+
+    /// Dispatch this kernel with the group counts stored as three consecutive
+    /// uint32_t values at byte |offset| of |args|, as written by a previous
+    /// kernel, and wait for it to finish. Always runs on the device. |offset|
+    /// must be a multiple of 4 with the three values inside |args|.
+    void dispatch_indirect(Buffer<uint32_t>& args, uint64_t offset = 0);
+
+    /// Run the host implementation of this kernel over |xelements| 
+    /// invocations, regardless of the context's host threshold. Throws if a
+    /// binding it accesses is unbound or too small.
+    void dispatch_host(uint64_t xelements);
+
+    /// Returns true if this kernel has a host implementation.
+    bool has_host_impl() const { return m_host_impl.fn != nullptr; }
+
+    /// Returns the number of invocations in a workgroup of this kernel.
+    uint32_t get_local_size_x() const { return m_local_size_x; }
+
+    /// Returns the descriptor bindings that the shader declares, which are
+    /// empty on host contexts.
+    const std::vector<uint32_t>& get_bindings() const { return m_bindings; }
+
+    /// Set the push constants recorded with subsequent dispatches of this
+    /// kernel. |data| must fit in the push constant block of the shader.
+    template<typename T>
+    void push(const T& data) {
+        push_bytes(&data, sizeof(T));
+    }
+
+    /// Set the push constants recorded with subsequent dispatches of this
+    /// kernel to the |size| bytes at |data|.
+    void push_bytes(const void* data, uint32_t size) {
+        if (size > m_push_size && !m_context.is_host())
+            throw rt_error("push constants exceed the kernel's block size.");
+
+        m_push.resize(size);
+        std::memcpy(m_push.data(), data, size);
+        capture::push(this, data, size);
+    }
+
+    /// Returns the push constants recorded with subsequent dispatches.
+    const std::vector<uint8_t>& get_push() const { return m_push; }
+
     template<typename T>
     void bind(uint32_t binding, Buffer<T>& buf) {
+        if (m_host_bindings.size() <= binding)
+            m_host_bindings.resize(binding + 1);
+
+        m_host_bindings[binding] = 
+            { buf.allocation(), buf.host_data(), buf.size() };
+        ++m_generation;
+        capture::bind(this, binding, &buf);
+
+        if (m_context.is_host())
+            return;
+
         VkDescriptorBufferInfo info {};
         info.buffer = buf;
         info.range = buf.size();
@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_PROFILE_H_
+#define GCL_PROFILE_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace gcl {
+
+class GCLContext;
+
+/// Measured characteristics of a device, and the dispatch parameters derived
+/// from them. A default constructed profile has measured nothing, and leaves
+/// the built-in defaults in place when applied to a context.
+struct DeviceProfile {
+    /// The device UUID as hex, which keys the profile cache.
+    std::string uuid;
+
+    /// The device name, for display only.
+    std::string device_name;
+
+    /// The driver version the profile was measured with. Cached profiles of
+    /// other driver versions are ignored.
+    uint32_t driver_version = 0;
+
+    /// Host to device bandwidth of Buffer::send in GB/s.
+    double upload_gbps = 0.0;
+
+    /// Device to host bandwidth of Buffer::fetch in GB/s.
+    double download_gbps = 0.0;
+
+    /// Device memory bandwidth of a copy kernel in GB/s, counting both the
+    /// bytes read and the bytes written.
+    double device_gbps = 0.0;
+
+    /// Time from recording a dispatch that does no work to its fence wait
+    /// returning, in microseconds.
+    double dispatch_us = 0.0;
+
+    /// Time from submitting an empty command buffer to its fence wait 
+    /// returning, in microseconds.
+    double submit_us = 0.0;
+
+    /// Time for one host thread to run one invocation of the ma kernel, in
+    /// nanoseconds.
+    double host_ns = 0.0;
+
+    /// Dispatches of fewer invocations than this finish sooner on the host.
+    uint64_t host_threshold = 0;
+
+    /// The minimum number of invocations worth giving to a host thread.
+    uint64_t host_grain = 0;
+
+    /// The fewest invocations that reach nearly the full device bandwidth,
+    /// whatever their workgroup size. Grid-stride kernels dispatch no more
+    /// than this.
+    uint64_t saturating_invocations = 0;
+
+    /// Returns true if this profile holds measurements.
+    bool is_measured() const { return !uuid.empty(); }
+};
+
+/// Measure the device of |context|. Takes around a second, during which the
+/// context must not be used by other threads. Throws on host contexts.
+DeviceProfile probe(GCLContext& context);
+
+/// Returns the path that the profile of the device with |uuid| is cached at:
+/// $XDG_CACHE_HOME/gcl/<uuid>.profile, or ~/.cache/gcl/<uuid>.profile if
+/// XDG_CACHE_HOME isn't set.
+std::string get_profile_path(const std::string& uuid);
+
+/// Returns the cached profile of the device of |context|, or nothing if it
+/// hasn't been cached, can't be read or was measured with another driver.
+std::optional<DeviceProfile> load_profile(const GCLContext& context);
+
+/// Write |profile| to the profile cache. Returns false if it couldn't be 
+/// written.
+bool save_profile(const DeviceProfile& profile);
+
+/// Returns the cached profile of the device of |context|, or probes and 
+/// caches it if there is none.
+DeviceProfile load_or_probe(GCLContext& context);
+
+} // namespace gcl
+
+#endif // GCL_PROFILE_H_
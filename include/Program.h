@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_PROGRAM_H_
+#define GCL_PROGRAM_H_
+
+#include "Buffer.h"
+#include "GCLContext.h"
+#include "Kernel.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace gcl {
+
+/// A sequence of kernel dispatches that is recorded into a command buffer 
+/// once and then submitted as a whole on every run, with a barrier between
+/// consecutive dispatches.
+///
+/// Buffer contents may change freely between runs, which then cost a single
+/// submission. Push constants are recorded into the command buffer, so
+/// changing them through push(), or rebinding any of the kernels, makes the
+/// next run re-record the whole command buffer first, adding the cost of
+/// recording every step to that run. examples/program.cpp measures both.
+/// A program must not be run from more than one thread at a time.
+class Program final {
+    /// A single dispatch of a program.
+    struct Step {
+        Kernel* kernel = nullptr;
+
+        /// The group counts of a direct dispatch.
+        uint32_t groups_x = 0;
+        uint32_t groups_y = 0;
+        uint32_t groups_z = 0;
+
+        /// The argument buffer and byte offset of an indirect dispatch.
+        VkBuffer args = nullptr;
+        uint64_t offset = 0;
+
+        /// The Buffer object of |args|, which identifies it in captures.
+        const void* args_buffer = nullptr;
+
+        /// The invocation count a host context runs this step with.
+        uint64_t xelements = 0;
+
+        /// The push constants of this step.
+        std::vector<uint8_t> push;
+
+        /// The generation of |kernel| when this step was added or last
+        /// recorded.
+        uint64_t generation = 0;
+    };
+
+    GCLContext& m_context;
+
+    VkCommandPool m_pool = nullptr;
+    VkCommandBuffer m_cmd = nullptr;
+
+    std::vector<Step> m_steps;
+
+    /// If true, the command buffer is out of date with |m_steps|.
+    bool m_dirty = true;
+
+    /// The timestamp queries of a timed program, one before the first step
+    /// and one after each step, or nullptr if the program isn't timed.
+    VkQueryPool m_queries = nullptr;
+
+    /// The number of queries in |m_queries|.
+    uint32_t m_query_count = 0;
+
+    /// Nanoseconds per timestamp tick, and the mask of valid timestamp bits
+    /// of the compute queue.
+    double m_timestamp_ns = 0.0;
+    uint64_t m_timestamp_mask = 0;
+
+    /// If true, each step is timed on the device.
+    bool m_timed = false;
+
+    /// The number of steps of the last timed run, whose timestamps are in
+    /// |m_queries|.
+    uint32_t m_timed_steps = 0;
+
+    /// Make |m_queries| hold at least |count| queries.
+    void reserve_queries(uint32_t count);
+
+    /// Re-record the command buffer from |m_steps|.
+    void record();
+
+    /// Throws if |kernel| is in this program and was rebound since. Each
+    /// kernel has a single descriptor set, so its steps can't have
+    /// different bindings.
+    void check_bindings(const Kernel& kernel) const;
+
+    /// Capture the dispatches of a run, if capturing.
+    void capture_run() const;
+
+public:
+    Program(GCLContext& context);
+
+    ~Program();
+
+    Program(const Program&) = delete;
+    void operator=(const Program&) = delete;
+
+    Program(Program&&) = delete;
+    void operator=(Program&&) = delete;
+
+    /// Append a dispatch of |kernel| over |xelements| invocations, with the
+    /// push constants currently set on the kernel. Returns the index of the
+    /// new step. All steps of a kernel share its bindings, so throws if the
+    /// kernel was rebound since it was last added or the program last ran.
+    uint32_t add(Kernel& kernel, uint32_t xelements, uint32_t ygroups = 1, 
+                 uint32_t zgroups = 1);
+
+    /// Append an indirect dispatch of |kernel| with the group counts at byte
+    /// |offset| of |args|, which must be a multiple of 4 with the three
+    /// values inside |args|. Returns the index of the new step. Throws on
+    /// rebound kernels as add() does.
+    uint32_t add_indirect(Kernel& kernel, Buffer<uint32_t>& args, 
+                          uint64_t offset = 0);
+
+    /// Replace the push constants of step |step|. The next run re-records
+    /// the program.
+    template<typename T>
+    void push(uint32_t step, const T& data) {
+        Step& s = m_steps.at(step);
+        if (sizeof(T) > s.kernel->m_push_size && !m_context.is_host())
+            throw rt_error("push constants exceed the kernel's block size.");
+
+        s.push.resize(sizeof(T));
+        std::memcpy(s.push.data(), &data, sizeof(T));
+        m_dirty = true;
+    }
+
+    /// Returns the number of dispatches in this program.
+    uint32_t size() const { return static_cast<uint32_t>(m_steps.size()); }
+
+    /// Remove all dispatches from this program.
+    void clear();
+
+    /// Submit every dispatch of this program and wait for them to finish.
+    void run();
+
+    /// Submit every dispatch of this program without waiting. The program
+    /// must not be run or changed again until the returned completion has
+    /// finished. Host contexts run the program synchronously.
+    Completion run_async();
+
+    /// Time each step on the device with timestamp queries from the next run
+    /// on, if |timed| is true. Changing this re-records the program. Throws
+    /// if the compute queue of the context has no timestamps.
+    void set_timed(bool timed);
+
+    /// Returns the device time of each step of the last run in microseconds,
+    /// measured from the end of the step before it. The run must have
+    /// finished. Empty if the program isn't timed, hasn't run since, or runs
+    /// on the host.
+    std::vector<double> get_step_us() const;
+};
+
+} // namespace gcl
+
+#endif // GCL_PROGRAM_H_
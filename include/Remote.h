@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_REMOTE_H_
+#define GCL_REMOTE_H_
+
+#include "Embedded.h"
+#include "RemoteProtocol.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gcl {
+
+/// A connection to a gcld daemon, which owns the device and runs the kernels
+/// of every process connected to it. Remote buffers live in shared memory,
+/// so sending and fetching them never goes through the socket.
+class RemoteContext final {
+    int m_socket = -1;
+
+    /// The alignment that shared memory is sized to.
+    uint64_t m_alignment = 1;
+
+    /// Serializes requests from multiple threads.
+    std::mutex m_lock;
+
+public:
+    /// Connect to the daemon listening on |path|.
+    explicit RemoteContext(
+        const std::string& path = remote::default_socket_path());
+
+    ~RemoteContext();
+
+    RemoteContext(const RemoteContext&) = delete;
+    void operator=(const RemoteContext&) = delete;
+
+    RemoteContext(RemoteContext&&) = delete;
+    void operator=(RemoteContext&&) = delete;
+
+    /// Returns the alignment that shared memory is sized to.
+    uint64_t get_alignment() const { return m_alignment; }
+
+    /// Send |request|, along with the file descriptor |fd| unless it is -1,
+    /// and wait for the reply. Throws if the daemon reports an error.
+    remote::Reply request(const remote::Request& request, int fd = -1);
+};
+
+/// Memory shared with the daemon through a memfd, sealed so that it can't
+/// shrink while the daemon has it mapped.
+class SharedMemory final {
+    int m_fd = -1;
+    void* m_data = nullptr;
+    uint64_t m_size = 0;
+
+public:
+    /// Create and map |size| bytes of shared memory.
+    explicit SharedMemory(uint64_t size);
+
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    void operator=(const SharedMemory&) = delete;
+
+    SharedMemory(SharedMemory&&) = delete;
+    void operator=(SharedMemory&&) = delete;
+
+    int fd() const { return m_fd; }
+    void* data() const { return m_data; }
+    uint64_t size() const { return m_size; }
+};
+
+/// Returns the shared memory size for |bytes| bytes on |context|.
+uint64_t shared_size(const RemoteContext& context, uint64_t bytes);
+
+/// Create a remote buffer of |bytes| bytes over |memory|, and return its id.
+uint32_t create_remote_buffer(RemoteContext& context, 
+                              const SharedMemory& memory, uint64_t bytes);
+
+/// Destroy the remote object |id| with |op|, ignoring errors, as this is
+/// called from destructors.
+void destroy_remote(RemoteContext& context, remote::Op op, uint32_t id);
+
+/// A buffer of the daemon's device, mirroring Buffer. Its contents live in
+/// memory shared with the daemon, so send() and fetch() are plain copies.
+template<typename T>
+class RemoteBuffer final {
+    RemoteContext& m_context;
+    uint64_t m_elements;
+
+    /// The size of this buffer in bytes, rounded up to whole 32-bit words as
+    /// for Buffer.
+    uint64_t m_size;
+
+    SharedMemory m_memory;
+    uint32_t m_id;
+
+public:
+    RemoteBuffer(RemoteContext& context, uint64_t N)
+            : m_context(context), m_elements(N),
+              m_size((sizeof(T) * N + 3) & ~uint64_t(3)),
+              m_memory(shared_size(context, m_size)),
+              m_id(create_remote_buffer(context, m_memory, m_size)) {}
+
+    ~RemoteBuffer() {
+        destroy_remote(m_context, remote::Op::DestroyBuffer, m_id);
+    }
+
+    RemoteBuffer(const RemoteBuffer&) = delete;
+    void operator=(const RemoteBuffer&) = delete;
+
+    RemoteBuffer(RemoteBuffer&&) = delete;
+    void operator=(RemoteBuffer&&) = delete;
+
+    /// Returns the id of this buffer on the daemon.
+    uint32_t id() const { return m_id; }
+
+    /// Returns the number of elements in this buffer.
+    uint64_t elements() const { return m_elements; }
+
+    /// Returns the size of this buffer in bytes.
+    uint64_t size() const { return m_size; }
+
+    /// Returns the shared memory of this buffer, which must not be accessed
+    /// while a dispatch that uses it runs.
+    T* data() const { return static_cast<T*>(m_memory.data()); }
+
+    void send(const std::vector<T>& data) const {
+        std::memcpy(m_memory.data(), data.data(),
+            std::min<uint64_t>(data.size(), m_elements) * sizeof(T));
+    }
+
+    std::vector<T> fetch() const {
+        std::vector<T> data(m_elements);
+        std::memcpy(data.data(), m_memory.data(), m_elements * sizeof(T));
+        return data;
+    }
+};
+
+/// A kernel run by the daemon, mirroring Kernel. Bindings and push constants
+/// are kept locally and sent along with every dispatch.
+class RemoteKernel final {
+    RemoteContext& m_context;
+    uint32_t m_id = 0;
+    uint32_t m_local_size_x = 1;
+
+    /// The dispatch request, holding the current bindings and push constants.
+    remote::Request m_dispatch;
+
+public:
+    /// Create a kernel called |name| from |spirv| on the daemon.
+    RemoteKernel(RemoteContext& context, const std::string& name,
+                 std::span<const uint32_t> spirv);
+
+    /// Create one of the kernels embedded in the library on the daemon.
+    RemoteKernel(RemoteContext& context, const embedded::Spirv& spirv);
+
+    ~RemoteKernel();
+
+    RemoteKernel(const RemoteKernel&) = delete;
+    void operator=(const RemoteKernel&) = delete;
+
+    RemoteKernel(RemoteKernel&&) = delete;
+    void operator=(RemoteKernel&&) = delete;
+
+    /// Returns the id of this kernel on the daemon.
+    uint32_t id() const { return m_id; }
+
+    /// Returns the number of invocations in a workgroup of this kernel.
+    uint32_t get_local_size_x() const { return m_local_size_x; }
+
+    template<typename T>
+    void bind(uint32_t binding, RemoteBuffer<T>& buf) {
+        if (binding >= remote::MAX_BINDINGS)
+            throw std::runtime_error("binding exceeds the remote maximum.");
+
+        m_dispatch.bindings[binding] = buf.id();
+    }
+
+    template<typename T>
+    void push(const T& data) {
+        push_bytes(&data, sizeof(T));
+    }
+
+    /// Set the push constants sent with subsequent dispatches to the |size|
+    /// bytes at |data|.
+    void push_bytes(const void* data, uint32_t size);
+
+    /// Dispatch this kernel over |xelements| invocations on the daemon and 
+    /// wait for it to finish.
+    void dispatch(int32_t xelements, int32_t ygroups = 1, int32_t zgroups = 1);
+};
+
+} // namespace gcl
+
+#endif // GCL_REMOTE_H_
@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_REMOTE_PROTOCOL_H_
+#define GCL_REMOTE_PROTOCOL_H_
+
+#include <cstdint>
+#include <string>
+
+/// The wire protocol between gcld and its clients. Every request and reply
+/// is a single fixed-size message on a SOCK_SEQPACKET Unix socket, and file
+/// descriptors travel alongside them as SCM_RIGHTS. A client has at most one
+/// request outstanding, and the daemon replies to each in order.
+namespace gcl::remote {
+
+/// The version of this protocol. The daemon refuses clients of another.
+inline constexpr uint32_t PROTOCOL_VERSION = 1;
+
+/// The most descriptor bindings a remote kernel can have.
+inline constexpr uint32_t MAX_BINDINGS = 16;
+
+/// The largest push constant block of a remote kernel, which is the least
+/// every Vulkan device supports.
+inline constexpr uint32_t MAX_PUSH = 128;
+
+/// The longest kernel name, including the terminator.
+inline constexpr uint32_t MAX_NAME = 64;
+
+/// The longest error message in a reply, including the terminator.
+inline constexpr uint32_t MAX_ERROR = 192;
+
+enum class Op : uint32_t {
+    /// Check the protocol version. Replies with the alignment that shared
+    /// memory must be sized to in |value|.
+    Hello = 1,
+
+    /// Create a buffer of |size| bytes over the memfd sent along with the
+    /// request, which must be sealed with F_SEAL_SHRINK. Replies with the id
+    /// of the buffer.
+    CreateBuffer,
+
+    /// Destroy the buffer |id|.
+    DestroyBuffer,
+
+    /// Create a kernel called |name| from the |size| bytes of SPIR-V in the
+    /// memfd sent along with the request, sealed as above. Replies with the
+    /// id of the kernel and its local size in |value|.
+    CreateKernel,
+
+    /// Destroy the kernel |id|.
+    DestroyKernel,
+
+    /// Bind |bindings| to the kernel |id|, set its push constants and 
+    /// dispatch it over |x| invocations and |y| by |z| groups. Every binding
+    /// of the kernel must be bound, and the group counts within the device's
+    /// limits. Replies when the dispatch has finished.
+    Dispatch,
+};
+
+struct Request {
+    Op op = Op::Hello;
+
+    /// The id of the buffer or kernel the request is about.
+    uint32_t id = 0;
+
+    /// The size of the shared memory sent along with the request in bytes, or
+    /// the protocol version for Op::Hello.
+    uint64_t size = 0;
+
+    /// The dispatch dimensions.
+    uint32_t x = 0;
+    uint32_t y = 1;
+    uint32_t z = 1;
+
+    /// The id of the buffer bound at every binding, or zero if unbound.
+    uint32_t bindings[MAX_BINDINGS] = {};
+
+    uint32_t push_size = 0;
+    uint8_t push[MAX_PUSH] = {};
+
+    char name[MAX_NAME] = {};
+};
+
+struct Reply {
+    /// Zero on success, in which case |error| is empty.
+    uint32_t status = 0;
+
+    /// The id of the created object.
+    uint32_t id = 0;
+
+    /// An op-specific result.
+    uint64_t value = 0;
+
+    char error[MAX_ERROR] = {};
+};
+
+/// Returns the socket that gcld listens on by default: $GCL_SOCKET if set,
+/// otherwise $XDG_RUNTIME_DIR/gcld.sock, or /tmp/gcld-<uid>.sock if that
+/// isn't set either.
+std::string default_socket_path();
+
+} // namespace gcl::remote
+
+#endif // GCL_REMOTE_PROTOCOL_H_
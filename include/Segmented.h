@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_SEGMENTED_H_
+#define GCL_SEGMENTED_H_
+
+#include "Buffer.h"
+#include "GCLContext.h"
+#include "Kernel.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gcl {
+
+/// Many small arrays, or segments, packed end to end into one buffer along
+/// with a table of where each segment starts. Sending and fetching a batch
+/// moves every segment in a single transfer.
+class SegmentedBatch final {
+    GCLContext& m_context;
+
+    /// The start of every segment in |m_data|, followed by the total size.
+    std::vector<uint32_t> m_offsets;
+
+    Buffer<float> m_data;
+    Buffer<uint32_t> m_offset_buf;
+
+public:
+    /// Create a batch of segments with the given |sizes|.
+    SegmentedBatch(GCLContext& context, const std::vector<uint32_t>& sizes);
+
+    SegmentedBatch(const SegmentedBatch&) = delete;
+    void operator=(const SegmentedBatch&) = delete;
+
+    SegmentedBatch(SegmentedBatch&&) = delete;
+    void operator=(SegmentedBatch&&) = delete;
+
+    /// Returns the number of segments.
+    uint32_t get_segments() const {
+        return static_cast<uint32_t>(m_offsets.size() - 1);
+    }
+
+    /// Returns the total number of elements over every segment.
+    uint32_t get_elements() const { return m_offsets.back(); }
+
+    /// Returns the start of every segment, followed by the total size.
+    const std::vector<uint32_t>& get_offsets() const { return m_offsets; }
+
+    /// Returns true if |other| has the same segment sizes as this batch.
+    bool same_layout(const SegmentedBatch& other) const {
+        return m_offsets == other.m_offsets;
+    }
+
+    /// The packed segments.
+    Buffer<float>& data() { return m_data; }
+
+    /// The offsets table, as uploaded to the device.
+    Buffer<uint32_t>& offsets() { return m_offset_buf; }
+
+    /// Pack |segments|, which must match the sizes of this batch, and send
+    /// them all at once.
+    void send(const std::vector<std::vector<float>>& segments);
+
+    /// Fetch every segment at once and unpack them.
+    std::vector<std::vector<float>> fetch() const;
+};
+
+/// The reductions supported by SegmentedOps::reduce. Empty segments reduce
+/// to 0, +inf and -inf respectively.
+enum class SegmentOp : uint32_t { Sum, Min, Max };
+
+/// Runs kernels over every segment of a batch in a single dispatch, with a
+/// workgroup per segment, instead of a dispatch per segment. On host 
+/// contexts, runs on the host.
+class SegmentedOps final {
+    GCLContext& m_context;
+
+    /// The kernels, on device contexts.
+    std::unique_ptr<Kernel> m_reduce;
+    std::unique_ptr<Kernel> m_ma;
+
+    /// The result of every segment of the last reduction, regrown as needed.
+    std::unique_ptr<Buffer<float>> m_results;
+
+public:
+    explicit SegmentedOps(GCLContext& context);
+
+    SegmentedOps(const SegmentedOps&) = delete;
+    void operator=(const SegmentedOps&) = delete;
+
+    SegmentedOps(SegmentedOps&&) = delete;
+    void operator=(SegmentedOps&&) = delete;
+
+    /// Reduce every segment of |batch| with |op| and return the results of
+    /// all segments, fetched together.
+    std::vector<float> reduce(SegmentedBatch& batch, SegmentOp op);
+
+    /// res = a * b + 1 elementwise over every segment. The three batches
+    /// must have the same layout.
+    void ma(SegmentedBatch& a, SegmentedBatch& b, SegmentedBatch& res);
+};
+
+} // namespace gcl
+
+#endif // GCL_SEGMENTED_H_
@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_SPARSE_H_
+#define GCL_SPARSE_H_
+
+#include "Buffer.h"
+#include "GCLContext.h"
+#include "Kernel.h"
+#include "Program.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gcl {
+
+/// A sparse matrix in compressed sparse row format, held on the host. The
+/// entries of row r are at [row_ptr[r], row_ptr[r + 1]) of |col_idx| and
+/// |values|, sorted by column.
+struct CsrMatrix {
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+
+    std::vector<uint32_t> row_ptr;
+    std::vector<uint32_t> col_idx;
+    std::vector<float> values;
+
+    /// Returns the number of stored entries.
+    uint64_t nnz() const { return values.size(); }
+
+    /// Build a matrix from coordinate triplets (|r|[i], |c|[i], |v|[i]) in any
+    /// order. Duplicate coordinates are summed.
+    static CsrMatrix from_coo(uint32_t rows, uint32_t cols,
+                              const std::vector<uint32_t>& r,
+                              const std::vector<uint32_t>& c,
+                              const std::vector<float>& v);
+};
+
+/// A sparse matrix in ELLPACK format, held on the host. Every row is padded
+/// to |width| entries, and entries are stored column major, entry k of row r
+/// at k * rows + r, so that neighbouring rows are read together. Suits
+/// matrices with rows of similar length, as padding grows with the longest.
+struct EllMatrix {
+    /// The column index of padding entries.
+    static constexpr uint32_t PADDING = 0xffffffff;
+
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    uint32_t width = 0;
+
+    std::vector<uint32_t> col_idx;
+    std::vector<float> values;
+
+    /// Convert |csr| to ELL, padding rows to its longest row.
+    static EllMatrix from_csr(const CsrMatrix& csr);
+};
+
+/// y = |a| * x on the host, in parallel over rows.
+void spmv(const CsrMatrix& a, const float* x, float* y);
+
+/// y = |a| * x on the host, in parallel over rows.
+void spmv(const EllMatrix& a, const float* x, float* y);
+
+/// The kernels CsrSpmv assigns rows to, by row length.
+enum class RowBin : uint32_t {
+    /// One invocation per row.
+    Scalar,
+
+    /// One subgroup per row.
+    Vector,
+
+    /// One workgroup per row.
+    Block,
+};
+
+static constexpr uint32_t NUM_ROW_BINS = 3;
+
+/// Multiplies a CSR matrix uploaded to the device by dense vectors.
+///
+/// Rows are binned by length when the matrix is uploaded, and every bin is
+/// processed by the kernel that suits it, so that a few very long rows don't
+/// stall the invocations handling the short ones. The bins are recorded into
+/// a program and run as a single submission. On host contexts, multiplies on
+/// the host.
+class CsrSpmv final {
+    GCLContext& m_context;
+
+    uint32_t m_rows;
+    uint32_t m_cols;
+
+    Buffer<uint32_t> m_row_ptr;
+    Buffer<uint32_t> m_col_idx;
+    Buffer<float> m_values;
+
+    /// The row indices of every bin, concatenated in bin order.
+    Buffer<uint32_t> m_binned;
+
+    /// The number of rows in each bin.
+    uint32_t m_bin_rows[NUM_ROW_BINS] = {};
+
+    /// The kernel of each non-empty bin, on device contexts.
+    std::unique_ptr<Kernel> m_kernels[NUM_ROW_BINS];
+
+    Program m_program;
+
+    /// The ids of the vectors last bound to the kernels. Rebinding
+    /// re-records the program, so it is skipped while they stay the same.
+    /// Ids are never reused, unlike Vulkan handles of destroyed buffers.
+    uint64_t m_bound_x = 0;
+    uint64_t m_bound_y = 0;
+
+public:
+    /// Upload |a| and bin its rows. Throws if |a| is malformed.
+    CsrSpmv(GCLContext& context, const CsrMatrix& a);
+
+    CsrSpmv(const CsrSpmv&) = delete;
+    void operator=(const CsrSpmv&) = delete;
+
+    CsrSpmv(CsrSpmv&&) = delete;
+    void operator=(CsrSpmv&&) = delete;
+
+    /// y = A * x, where |x| has as many elements as A has columns, and |y| as
+    /// many as A has rows. Waits for the result.
+    void multiply(Buffer<float>& x, Buffer<float>& y);
+
+    /// Returns the number of rows assigned to |bin|.
+    uint32_t get_bin_rows(RowBin bin) const {
+        return m_bin_rows[static_cast<uint32_t>(bin)];
+    }
+};
+
+/// Multiplies an ELL matrix uploaded to the device by dense vectors, with one
+/// invocation per row. On host contexts, multiplies on the host.
+class EllSpmv final {
+    GCLContext& m_context;
+
+    uint32_t m_rows;
+    uint32_t m_cols;
+    uint32_t m_width;
+
+    Buffer<uint32_t> m_col_idx;
+    Buffer<float> m_values;
+
+    /// The multiply kernel, on device contexts.
+    std::unique_ptr<Kernel> m_kernel;
+
+public:
+    /// Upload |a|.
+    EllSpmv(GCLContext& context, const EllMatrix& a);
+
+    EllSpmv(const EllSpmv&) = delete;
+    void operator=(const EllSpmv&) = delete;
+
+    EllSpmv(EllSpmv&&) = delete;
+    void operator=(EllSpmv&&) = delete;
+
+    /// y = A * x, where |x| has as many elements as A has columns, and |y| as
+    /// many as A has rows. Waits for the result.
+    void multiply(Buffer<float>& x, Buffer<float>& y);
+};
+
+} // namespace gcl
+
+#endif // GCL_SPARSE_H_
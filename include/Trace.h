@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_TRACE_H_
+#define GCL_TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace gcl::trace {
+
+/// Host-side counters kept per thread.
+enum class Counter : uint32_t {
+    BytesUploaded,
+    BytesDownloaded,
+    Dispatches,
+    HostDispatches,
+    Submits,
+    SubmitNs,
+    FenceWaitNs,
+    PipelineCreations,
+    PipelineCreateNs,
+    SpilledAllocations,
+
+    /// Not a counter, the number of counters. Also used by Scope to mean
+    /// that no counter accumulates its duration.
+    None,
+};
+
+static constexpr uint32_t NUM_COUNTERS = static_cast<uint32_t>(Counter::None);
+
+/// A snapshot of counter values.
+struct Counters {
+    uint64_t values[NUM_COUNTERS] = {};
+
+    uint64_t operator[](Counter counter) const {
+        return values[static_cast<uint32_t>(counter)];
+    }
+};
+
+/// Returns a printable name for |counter|.
+const char* to_string(Counter counter);
+
+namespace detail {
+
+static constexpr uint32_t COUNTERS_BIT = 1 << 0;
+static constexpr uint32_t EVENTS_BIT = 1 << 1;
+
+/// Which parts of instrumentation are enabled at runtime.
+extern std::atomic<uint32_t> g_flags;
+
+void add(Counter counter, uint64_t n);
+
+void record_event(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+/// Returns the current time in nanoseconds since the trace epoch.
+inline uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace detail
+
+/// Returns true if counters are being collected.
+inline bool is_enabled() {
+    return detail::g_flags.load(std::memory_order_relaxed)
+        & detail::COUNTERS_BIT;
+}
+
+/// Returns true if scoped trace events are being recorded.
+inline bool is_tracing() {
+    return detail::g_flags.load(std::memory_order_relaxed)
+        & detail::EVENTS_BIT;
+}
+
+/// Enable or disable counter collection. Counters are enabled on startup if
+/// the GCL_TRACE environment variable is set.
+void set_enabled(bool enabled);
+
+/// Enable or disable trace event recording. Events are enabled on startup if
+/// the GCL_TRACE environment variable is set, and written to the path in
+/// GCL_TRACE_FILE on exit if that is set too.
+void set_tracing(bool tracing);
+
+/// Add |n| to |counter| of the calling thread, if counters are enabled.
+inline void add(Counter counter, uint64_t n) {
+    if (is_enabled())
+        detail::add(counter, n);
+}
+
+/// Returns the sum of the counters of every thread.
+Counters snapshot();
+
+/// Reset the counters of every thread to zero and drop all recorded events.
+void reset();
+
+/// Write the recorded events as Chrome trace event JSON to |path|, which can
+/// be loaded into chrome://tracing or Perfetto. Returns false if the file
+/// could not be written.
+bool write_chrome_trace(const std::string& path);
+
+/// Times the enclosing scope, accumulating its duration into a counter and
+/// recording it as a trace event, if either is enabled.
+class Scope final {
+    const char* m_name;
+    Counter m_counter;
+    uint64_t m_start = 0;
+
+public:
+    Scope(const char* name, Counter counter = Counter::None)
+            : m_name(name), m_counter(counter) {
+        if (detail::g_flags.load(std::memory_order_relaxed) != 0)
+            m_start = detail::now();
+    }
+
+    ~Scope() {
+        if (m_start == 0)
+            return;
+
+        uint64_t end = detail::now();
+        if (m_counter != Counter::None && is_enabled())
+            detail::add(m_counter, end - m_start);
+        if (is_tracing())
+            detail::record_event(m_name, m_start, end);
+    }
+
+    Scope(const Scope&) = delete;
+    void operator=(const Scope&) = delete;
+};
+
+} // namespace gcl::trace
+
+#define GCL_TRACE_CONCAT_(a, b) a##b
+#define GCL_TRACE_CONCAT(a, b) GCL_TRACE_CONCAT_(a, b)
+
+#ifdef USE_INSTRUMENTATION
+    #define GCL_COUNT(counter, n) \
+        gcl::trace::add(gcl::trace::Counter::counter, n)
+    #define GCL_SCOPE(name) \
+        gcl::trace::Scope GCL_TRACE_CONCAT(gcl_scope_, __LINE__)(name)
+    #define GCL_TIMED_SCOPE(name, counter)                        \
+        gcl::trace::Scope GCL_TRACE_CONCAT(gcl_scope_, __LINE__)( \
+            name, gcl::trace::Counter::counter)
+#else
+    #define GCL_COUNT(counter, n) do {} while (0)
+    #define GCL_SCOPE(name) do {} while (0)
+    #define GCL_TIMED_SCOPE(name, counter) do {} while (0)
+#endif // USE_INSTRUMENTATION
+
+#endif // GCL_TRACE_H_
@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#ifndef GCL_TYPES_H_
+#define GCL_TYPES_H_
+
+#include <cstdint>
+#include <cstring>
+
+namespace gcl {
+
+/// An IEEE 754 binary16 value, used as a storage type for buffers that are
+/// expanded to 32-bit floats on the device.
+struct half final {
+    uint16_t bits = 0;
+
+    half() = default;
+
+    explicit half(float value) : bits(from_float(value)) {}
+
+    explicit operator float() const { return to_float(bits); }
+
+    /// Convert |value| to binary16, rounding to nearest even.
+    static uint16_t from_float(float value) {
+        uint32_t u;
+        std::memcpy(&u, &value, sizeof(u));
+
+        uint32_t sign = (u >> 16) & 0x8000;
+        int32_t exp = static_cast<int32_t>((u >> 23) & 0xff) - 127 + 15;
+        uint32_t mant = u & 0x7fffff;
+
+        // Infinity and NaN, keeping NaNs quiet.
+        if (((u >> 23) & 0xff) == 0xff)
+            return sign | 0x7c00 | (mant != 0 ? 0x200 : 0);
+
+        // Overflows to infinity.
+        if (exp >= 31)
+            return sign | 0x7c00;
+
+        // Subnormal or zero.
+        if (exp <= 0) {
+            if (exp < -10)
+                return sign;
+
+            mant |= 0x800000;
+            uint32_t shift = 14 - exp;
+            uint32_t res = mant >> shift;
+            uint32_t rem = mant & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (rem > halfway || (rem == halfway && (res & 1)))
+                ++res;
+
+            return sign | res;
+        }
+
+        uint32_t res = (exp << 10) | (mant >> 13);
+        uint32_t rem = mant & 0x1fff;
+        if (rem > 0x1000 || (rem == 0x1000 && (res & 1)))
+            ++res; // May carry into the exponent, which is still correct.
+
+        return sign | res;
+    }
+
+    /// Convert the binary16 value |bits| to a float.
+    static float to_float(uint16_t bits) {
+        uint32_t sign = static_cast<uint32_t>(bits & 0x8000) << 16;
+        uint32_t exp = (bits >> 10) & 0x1f;
+        uint32_t mant = bits & 0x3ff;
+
+        uint32_t u;
+        if (exp == 0x1f) {
+            u = sign | 0x7f800000 | (mant << 13);
+        } else if (exp != 0) {
+            u = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+        } else if (mant == 0) {
+            u = sign;
+        } else {
+            // Normalize the subnormal.
+            exp = 127 - 15 + 1;
+            while ((mant & 0x400) == 0) {
+                mant <<= 1;
+                --exp;
+            }
+
+            u = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+        }
+
+        float value;
+        std::memcpy(&value, &u, sizeof(value));
+        return value;
+    }
+};
+
+/// A bfloat16 value, the upper half of a 32-bit float, used as a storage type
+/// for buffers that are expanded to 32-bit floats on the device.
+struct bfloat16 final {
+    uint16_t bits = 0;
+
+    bfloat16() = default;
+
+    explicit bfloat16(float value) : bits(from_float(value)) {}
+
+    explicit operator float() const { return to_float(bits); }
+
+    /// Convert |value| to bfloat16, rounding to nearest even.
+    static uint16_t from_float(float value) {
+        uint32_t u;
+        std::memcpy(&u, &value, sizeof(u));
+
+        if ((u & 0x7fffffff) > 0x7f800000)
+            return (u >> 16) | 0x40;
+
+        u += 0x7fff + ((u >> 16) & 1);
+        return u >> 16;
+    }
+
+    /// Convert the bfloat16 value |bits| to a float.
+    static float to_float(uint16_t bits) {
+        uint32_t u = static_cast<uint32_t>(bits) << 16;
+
+        float value;
+        std::memcpy(&value, &u, sizeof(value));
+        return value;
+    }
+};
+
+static_assert(sizeof(half) == 2, "half must be 16 bits.");
+static_assert(sizeof(bfloat16) == 2, "bfloat16 must be 16 bits.");
+
+} // namespace gcl
+
+#endif // GCL_TYPES_H_
@@ -3,3 +3,25 @@
 glslang -V ma.comp -o ma.spv
 glslang -V branch.comp -o branch.spv
 glslang -V heavy.comp -o heavy.spv
+glslang -V groups.comp -o groups.spv
+glslang -V filter.comp -o filter.spv
+glslang -V square.comp -o square.spv
+glslang -V f16_expand.comp -o f16_expand.spv
+glslang -V f16_pack.comp -o f16_pack.spv
+glslang -V f16_expand_native.comp -o f16_expand_native.spv
+glslang -V f16_pack_native.comp -o f16_pack_native.spv
+glslang -V bf16_expand.comp -o bf16_expand.spv
+glslang -V bf16_pack.comp -o bf16_pack.spv
+glslang -V i8_expand.comp -o i8_expand.spv
+glslang -V i8_pack.comp -o i8_pack.spv
+glslang -V i8_expand_native.comp -o i8_expand_native.spv
+glslang -V i8_pack_native.comp -o i8_pack_native.spv
+glslang -V --target-env vulkan1.3 spmv_csr_scalar.comp -o spmv_csr_scalar.spv
+glslang -V --target-env vulkan1.3 spmv_csr_vector.comp -o spmv_csr_vector.spv
+glslang -V --target-env vulkan1.3 spmv_csr_block.comp -o spmv_csr_block.spv
+glslang -V --target-env vulkan1.3 spmv_ell.comp -o spmv_ell.spv
+glslang -V histogram_f32.comp -o histogram_f32.spv
+glslang -V histogram_u32.comp -o histogram_u32.spv
+glslang -V seg_reduce.comp -o seg_reduce.spv
+glslang -V seg_ma.comp -o seg_ma.spv
+glslang -V probe_copy.comp -o probe_copy.spv
@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Async.h"
+
+#include <cerrno>
+#include <cstdint>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+using namespace gcl;
+
+/// The maximum number of events taken from epoll per call.
+static constexpr int MAX_EVENTS = 256;
+
+void Task::promise_type::return_void() {
+    --reactor->m_tasks;
+}
+
+void Task::promise_type::unhandled_exception() {
+    if (!reactor->m_error)
+        reactor->m_error = std::current_exception();
+
+    --reactor->m_tasks;
+}
+
+Reactor::Reactor() {
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0)
+        throw rt_error("failed to create epoll descriptor.");
+}
+
+Reactor::~Reactor() {
+    ::close(m_epoll);
+}
+
+void Reactor::spawn(Task task) {
+    std::coroutine_handle<Task::promise_type> handle =
+        std::exchange(task.m_handle, nullptr);
+
+    handle.promise().reactor = this;
+    ++m_tasks;
+    handle.resume();
+}
+
+void Reactor::watch(int fd, std::coroutine_handle<> handle) {
+    epoll_event event {};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.fd = fd;
+
+    if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+        throw rt_error("failed to watch completion descriptor.");
+
+    m_watched[fd] = handle;
+}
+
+uint32_t Reactor::poll(int timeout) {
+    if (m_watched.empty())
+        return 0;
+
+    epoll_event events[MAX_EVENTS];
+    int num_events = ::epoll_wait(m_epoll, events, MAX_EVENTS, timeout);
+    if (num_events < 0) {
+        if (errno == EINTR)
+            return 0;
+
+        throw rt_error("failed to wait for completion descriptors.");
+    }
+
+    // Deregister every descriptor before resuming any task, since a resumed
+    // task closes the descriptor it waited on and may watch a new one that
+    // reuses its number.
+    std::coroutine_handle<> ready[MAX_EVENTS];
+    for (int idx = 0; idx < num_events; ++idx) {
+        int fd = events[idx].data.fd;
+        ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+
+        auto it = m_watched.find(fd);
+        ready[idx] = it->second;
+        m_watched.erase(it);
+    }
+
+    for (int idx = 0; idx < num_events; ++idx)
+        ready[idx].resume();
+
+    return static_cast<uint32_t>(num_events);
+}
+
+void Reactor::run() {
+    while (m_tasks != 0) {
+        if (m_watched.empty())
+            throw rt_error("tasks are suspended on something other than "
+                "this reactor.");
+
+        poll(-1);
+    }
+
+    if (m_error)
+        std::rethrow_exception(std::exchange(m_error, nullptr));
+}
@@ -0,0 +1,352 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Capture.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+using namespace gcl;
+
+using rt_error = std::runtime_error;
+using Type = capture::Record::Type;
+
+/// The size of the capture file's write buffer.
+static constexpr size_t WRITE_BUFFER = 1 << 20;
+
+std::atomic<bool> capture::detail::g_active = false;
+
+namespace {
+
+struct CaptureState {
+    std::mutex lock;
+    std::FILE* file = nullptr;
+    bool contents = false;
+};
+
+} // namespace
+
+static CaptureState& get_state() {
+    static CaptureState state;
+    return state;
+}
+
+/// Reads the GCL_CAPTURE and GCL_CAPTURE_CONTENTS environment variables on
+/// startup.
+static const bool g_env_init = []() {
+    const char* path = std::getenv("GCL_CAPTURE");
+    if (path == nullptr || *path == '\0')
+        return false;
+
+    const char* contents = std::getenv("GCL_CAPTURE_CONTENTS");
+    bool with_contents = contents != nullptr && std::string(contents) != "0";
+    if (!capture::start(path, with_contents))
+        return false;
+
+    std::atexit(capture::stop);
+    return true;
+}();
+
+const char* capture::to_string(Type type) {
+    switch (type) {
+    case Type::CreateBuffer:
+        return "create_buffer";
+    case Type::DestroyBuffer:
+        return "destroy_buffer";
+    case Type::CreateKernel:
+        return "create_kernel";
+    case Type::DestroyKernel:
+        return "destroy_kernel";
+    case Type::Bind:
+        return "bind";
+    case Type::Push:
+        return "push";
+    case Type::Send:
+        return "send";
+    case Type::Fetch:
+        return "fetch";
+    case Type::Dispatch:
+        return "dispatch";
+    case Type::DispatchIndirect:
+        return "dispatch_indirect";
+    case Type::BeginProgram:
+        return "begin_program";
+    case Type::EndProgram:
+        return "end_program";
+    }
+
+    return "unknown";
+}
+
+bool capture::start(const std::string& path, bool contents) {
+    CaptureState& state = get_state();
+    std::lock_guard<std::mutex> guard(state.lock);
+
+    if (state.file != nullptr) {
+        std::fclose(state.file);
+        state.file = nullptr;
+    }
+
+    detail::g_active.store(false);
+
+    state.file = std::fopen(path.c_str(), "wb");
+    if (state.file == nullptr)
+        return false;
+
+    std::setvbuf(state.file, nullptr, _IOFBF, WRITE_BUFFER);
+    std::fwrite(MAGIC, sizeof(MAGIC), 1, state.file);
+    std::fwrite(&VERSION, sizeof(VERSION), 1, state.file);
+
+    state.contents = contents;
+    detail::g_active.store(true);
+    return true;
+}
+
+void capture::stop() {
+    CaptureState& state = get_state();
+    std::lock_guard<std::mutex> guard(state.lock);
+
+    detail::g_active.store(false);
+    if (state.file != nullptr) {
+        std::fclose(state.file);
+        state.file = nullptr;
+    }
+}
+
+template<typename T>
+static void put(std::FILE* file, const T& value) {
+    std::fwrite(&value, sizeof(T), 1, file);
+}
+
+template<typename Size>
+static void put_bytes(std::FILE* file, const void* data, Size size) {
+    put(file, size);
+    if (size != 0)
+        std::fwrite(data, 1, size, file);
+}
+
+void capture::detail::write(const Record& record) {
+    CaptureState& state = get_state();
+    std::lock_guard<std::mutex> guard(state.lock);
+
+    std::FILE* file = state.file;
+    if (file == nullptr)
+        return;
+
+    put(file, static_cast<uint32_t>(record.type));
+
+    switch (record.type) {
+    case Type::CreateBuffer:
+        put(file, record.id);
+        put(file, record.size);
+        break;
+    case Type::DestroyBuffer:
+    case Type::DestroyKernel:
+    case Type::Fetch:
+        put(file, record.id);
+        break;
+    case Type::CreateKernel:
+        put(file, record.id);
+        put_bytes(file, record.name.data(), 
+            static_cast<uint32_t>(record.name.size()));
+        put_bytes(file, record.data.data(), 
+            static_cast<uint64_t>(record.data.size()));
+        break;
+    case Type::Bind:
+        put(file, record.id);
+        put(file, record.binding);
+        put(file, record.target);
+        break;
+    case Type::Push:
+        put(file, record.id);
+        put_bytes(file, record.data.data(),
+            static_cast<uint32_t>(record.data.size()));
+        break;
+    case Type::Send: {
+        put(file, record.id);
+        put(file, record.size);
+
+        uint8_t has_data = record.data.empty() ? 0 : 1;
+        put(file, has_data);
+        if (has_data)
+            std::fwrite(record.data.data(), 1, record.data.size(), file);
+
+        break;
+    }
+    case Type::Dispatch:
+        put(file, record.id);
+        put(file, record.x);
+        put(file, record.y);
+        put(file, record.z);
+        break;
+    case Type::DispatchIndirect:
+        put(file, record.id);
+        put(file, record.target);
+        put(file, record.size);
+        break;
+    case Type::BeginProgram:
+    case Type::EndProgram:
+        break;
+    }
+}
+
+void capture::detail::create_kernel(const void* id, const std::string& name,
+                                    const uint32_t* spirv, uint64_t words) {
+    Record record;
+    record.type = Type::CreateKernel;
+    record.id = reinterpret_cast<uintptr_t>(id);
+    record.name = name;
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(spirv);
+    record.data.assign(bytes, bytes + words * sizeof(uint32_t));
+    write(record);
+}
+
+void capture::detail::push(const void* id, const void* data, uint32_t size) {
+    Record record;
+    record.type = Type::Push;
+    record.id = reinterpret_cast<uintptr_t>(id);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    record.data.assign(bytes, bytes + size);
+    write(record);
+}
+
+void capture::detail::send(const void* id, const void* data, uint64_t size) {
+    Record record;
+    record.type = Type::Send;
+    record.id = reinterpret_cast<uintptr_t>(id);
+    record.size = size;
+
+    CaptureState& state = get_state();
+    std::unique_lock<std::mutex> guard(state.lock);
+    bool contents = state.contents;
+    guard.unlock();
+
+    if (contents) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        record.data.assign(bytes, bytes + size);
+    }
+
+    write(record);
+}
+
+capture::Reader::Reader(const std::string& path) {
+    m_file = std::fopen(path.c_str(), "rb");
+    if (m_file == nullptr)
+        throw rt_error("failed to open capture: " + path);
+
+    char magic[sizeof(MAGIC)];
+    uint32_t version = 0;
+    bool valid = std::fread(magic, sizeof(magic), 1, m_file) == 1
+        && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+        && std::fread(&version, sizeof(version), 1, m_file) == 1;
+
+    if (!valid) {
+        std::fclose(m_file);
+        throw rt_error("not a capture file: " + path);
+    }
+
+    if (version != VERSION) {
+        std::fclose(m_file);
+        throw rt_error("unsupported capture version " 
+            + std::to_string(version) + ": " + path);
+    }
+}
+
+capture::Reader::~Reader() {
+    std::fclose(m_file);
+}
+
+template<typename T>
+static void get(std::FILE* file, T& value) {
+    if (std::fread(&value, sizeof(T), 1, file) != 1)
+        throw rt_error("truncated capture file.");
+}
+
+template<typename Size, typename Container>
+static void get_bytes(std::FILE* file, Container& out) {
+    Size size = 0;
+    get(file, size);
+
+    out.resize(size);
+    if (size != 0 && std::fread(out.data(), 1, size, file) != size)
+        throw rt_error("truncated capture file.");
+}
+
+bool capture::Reader::next(Record& record) {
+    uint32_t type = 0;
+    if (std::fread(&type, sizeof(type), 1, m_file) != 1) {
+        if (std::feof(m_file))
+            return false;
+
+        throw rt_error("failed to read capture file.");
+    }
+
+    record = Record();
+    record.type = static_cast<Type>(type);
+
+    switch (record.type) {
+    case Type::CreateBuffer:
+        get(m_file, record.id);
+        get(m_file, record.size);
+        break;
+    case Type::DestroyBuffer:
+    case Type::DestroyKernel:
+    case Type::Fetch:
+        get(m_file, record.id);
+        break;
+    case Type::CreateKernel:
+        get(m_file, record.id);
+        get_bytes<uint32_t>(m_file, record.name);
+        get_bytes<uint64_t>(m_file, record.data);
+        break;
+    case Type::Bind:
+        get(m_file, record.id);
+        get(m_file, record.binding);
+        get(m_file, record.target);
+        break;
+    case Type::Push:
+        get(m_file, record.id);
+        get_bytes<uint32_t>(m_file, record.data);
+        break;
+    case Type::Send: {
+        get(m_file, record.id);
+        get(m_file, record.size);
+
+        uint8_t has_data = 0;
+        get(m_file, has_data);
+        if (has_data) {
+            record.data.resize(record.size);
+            if (std::fread(record.data.data(), 1, record.size, m_file) 
+                  != record.size)
+                throw rt_error("truncated capture file.");
+        }
+
+        break;
+    }
+    case Type::Dispatch:
+        get(m_file, record.id);
+        get(m_file, record.x);
+        get(m_file, record.y);
+        get(m_file, record.z);
+        break;
+    case Type::DispatchIndirect:
+        get(m_file, record.id);
+        get(m_file, record.target);
+        get(m_file, record.size);
+        break;
+    case Type::BeginProgram:
+    case Type::EndProgram:
+        break;
+    default:
+        throw rt_error("unknown record in capture file.");
+    }
+
+    return true;
+}
@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Completion.h"
+#include "../include/GCLContext.h"
+#include "../include/Trace.h"
+
+#include <cerrno>
+#include <exception>
+#include <iostream>
+#include <utility>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace gcl;
+
+/// Poll |fd| for readability for up to |timeout| milliseconds, retrying if
+/// interrupted by a signal. Returns true if it is readable.
+static bool poll_readable(int fd, int timeout) {
+    pollfd pfd {};
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    for (;;) {
+        int res = ::poll(&pfd, 1, timeout);
+        if (res >= 0)
+            return res > 0;
+
+        if (errno != EINTR)
+            throw rt_error("failed to poll completion descriptor.");
+    }
+}
+
+Completion::Completion() : m_done(true) {
+    m_fd = ::eventfd(1, EFD_CLOEXEC);
+    if (m_fd < 0)
+        throw rt_error("failed to create completion descriptor.");
+}
+
+Completion::Completion(GCLContext* context, VkCommandPool pool,
+                       VkCommandBuffer cmd, VkFence fence, int fd,
+                       bool exported)
+        : m_context(context), m_pool(pool), m_cmd(cmd), m_fence(fence),
+          m_fd(fd), m_exported(exported) {}
+
+Completion::~Completion() {
+    wait_or_abandon();
+
+    if (m_fd >= 0)
+        ::close(m_fd);
+}
+
+Completion::Completion(Completion&& other) noexcept
+        : m_context(std::exchange(other.m_context, nullptr)),
+          m_pool(std::exchange(other.m_pool, nullptr)),
+          m_cmd(std::exchange(other.m_cmd, nullptr)),
+          m_fence(std::exchange(other.m_fence, nullptr)),
+          m_fd(std::exchange(other.m_fd, -1)),
+          m_exported(other.m_exported),
+          m_done(std::exchange(other.m_done, true)) {}
+
+Completion& Completion::operator=(Completion&& other) noexcept {
+    if (this == &other)
+        return *this;
+
+    wait_or_abandon();
+
+    if (m_fd >= 0)
+        ::close(m_fd);
+
+    m_context = std::exchange(other.m_context, nullptr);
+    m_pool = std::exchange(other.m_pool, nullptr);
+    m_cmd = std::exchange(other.m_cmd, nullptr);
+    m_fence = std::exchange(other.m_fence, nullptr);
+    m_fd = std::exchange(other.m_fd, -1);
+    m_exported = other.m_exported;
+    m_done = std::exchange(other.m_done, true);
+    return *this;
+}
+
+bool Completion::ready() {
+    if (m_done)
+        return true;
+
+    if (!poll_readable(m_fd, 0))
+        return false;
+
+    finish();
+    return true;
+}
+
+void Completion::wait() {
+    if (m_done)
+        return;
+
+    {
+        GCL_TIMED_SCOPE("Completion::wait", FenceWaitNs);
+        poll_readable(m_fd, -1);
+    }
+
+    finish();
+}
+
+void Completion::wait_or_abandon() noexcept {
+    if (m_done || m_context == nullptr)
+        return;
+
+    try {
+        wait();
+    } catch (const std::exception& e) {
+        std::cerr << "abandoning completion: " << e.what() << '\n';
+        m_done = true;
+    }
+}
+
+void Completion::finish() {
+    m_done = true;
+
+    // An exported fence was reset by the export, otherwise it is still
+    // signaled and must be reset before it is reused.
+    if (m_exported
+          || vkResetFences(m_context->get_device(), 1, &m_fence)
+            == VK_SUCCESS) {
+        m_context->release_fence(m_fence);
+    }
+
+    if (m_pool != nullptr)
+        m_context->release_command_buffer(m_pool, m_cmd);
+}
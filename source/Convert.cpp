@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+using namespace gcl;
+
+/// Push constants of the conversion kernels.
+struct ConvertParams {
+    uint32_t n;
+    float scale;
+};
+
+/// Quantize |x| to a signed 8-bit value, as in kernels/i8_pack.comp.
+static int8_t quantize(float x, float scale) {
+    return static_cast<int8_t>(
+        std::clamp(std::nearbyint(x / scale), -127.f, 127.f));
+}
+
+Converter::Converter(GCLContext& context, const std::string& dir)
+        : m_context(context), m_dir(dir) {}
+
+Kernel& Converter::get_kernel(const std::string& name) {
+    auto it = m_kernels.find(name);
+    if (it != m_kernels.end())
+        return *it->second;
+
+    std::unique_ptr<Kernel> kernel;
+    if (m_dir.empty()) {
+        const embedded::Spirv* spirv = embedded::find(name);
+        if (spirv == nullptr)
+            throw rt_error("no embedded kernel: " + name);
+
+        kernel = std::make_unique<Kernel>(m_context, *spirv);
+    } else {
+        kernel = std::make_unique<Kernel>(
+            m_context, m_dir + "/" + name + ".spv");
+    }
+
+    Kernel& ref = *kernel;
+    m_kernels.emplace(name, std::move(kernel));
+    return ref;
+}
+
+/// Throws unless |out| can hold the conversion of every element of |in|.
+template<typename In, typename Out>
+static void check_output(const Buffer<In>& in, const Buffer<Out>& out) {
+    if (out.elements() < in.elements())
+        throw rt_error("conversion output buffer is too small.");
+}
+
+template<typename In, typename Out>
+void Converter::convert(const std::string& name, bool native, 
+                        uint32_t per_word, Buffer<In>& in, Buffer<Out>& out,
+                        uint64_t n, float scale) {
+    Kernel& kernel = get_kernel(native ? name + "_native" : name);
+    kernel.bind(0, in);
+    kernel.bind(1, out);
+    kernel.push(ConvertParams { static_cast<uint32_t>(n), scale });
+
+    uint64_t invocations = native ? n : (n + per_word - 1) / per_word;
+    kernel.dispatch(static_cast<int32_t>(invocations));
+}
+
+void Converter::expand(Buffer<half>& in, Buffer<float>& out) {
+    check_output(in, out);
+
+    if (m_context.is_host()) {
+        const half* src = static_cast<const half*>(in.host_data());
+        float* dst = static_cast<float*>(out.host_data());
+        for (uint64_t i = 0; i < in.elements(); ++i)
+            dst[i] = float(src[i]);
+
+        return;
+    }
+
+    convert("f16_expand", m_context.get_features().storage_buffer_16bit, 2,
+        in, out, in.elements(), 1.f);
+}
+
+void Converter::pack(Buffer<float>& in, Buffer<half>& out) {
+    check_output(in, out);
+
+    if (m_context.is_host()) {
+        const float* src = static_cast<const float*>(in.host_data());
+        half* dst = static_cast<half*>(out.host_data());
+        for (uint64_t i = 0; i < in.elements(); ++i)
+            dst[i] = half(src[i]);
+
+        return;
+    }
+
+    convert("f16_pack", m_context.get_features().storage_buffer_16bit, 2,
+        in, out, in.elements(), 1.f);
+}
+
+void Converter::expand(Buffer<bfloat16>& in, Buffer<float>& out) {
+    check_output(in, out);
+
+    if (m_context.is_host()) {
+        const bfloat16* src = static_cast<const bfloat16*>(in.host_data());
+        float* dst = static_cast<float*>(out.host_data());
+        for (uint64_t i = 0; i < in.elements(); ++i)
+            dst[i] = float(src[i]);
+
+        return;
+    }
+
+    // There is no native bfloat16 storage, it is always unpacked from words.
+    convert("bf16_expand", false, 2, in, out, in.elements(), 1.f);
+}
+
+void Converter::pack(Buffer<float>& in, Buffer<bfloat16>& out) {
+    check_output(in, out);
+
+    if (m_context.is_host()) {
+        const float* src = static_cast<const float*>(in.host_data());
+        bfloat16* dst = static_cast<bfloat16*>(out.host_data());
+        for (uint64_t i = 0; i < in.elements(); ++i)
+            dst[i] = bfloat16(src[i]);
+
+        return;
+    }
+
+    convert("bf16_pack", false, 2, in, out, in.elements(), 1.f);
+}
+
+void Converter::expand(Buffer<int8_t>& in, Buffer<float>& out, float scale) {
+    check_output(in, out);
+
+    if (m_context.is_host()) {
+        const int8_t* src = static_cast<const int8_t*>(in.host_data());
+        float* dst = static_cast<float*>(out.host_data());
+        for (uint64_t i = 0; i < in.elements(); ++i)
+            dst[i] = float(src[i]) * scale;
+
+        return;
+    }
+
+    convert("i8_expand", m_context.get_features().storage_buffer_8bit, 4,
+        in, out, in.elements(), scale);
+}
+
+void Converter::pack(Buffer<float>& in, Buffer<int8_t>& out, float scale) {
+    check_output(in, out);
+
+    if (m_context.is_host()) {
+        const float* src = static_cast<const float*>(in.host_data());
+        int8_t* dst = static_cast<int8_t*>(out.host_data());
+        for (uint64_t i = 0; i < in.elements(); ++i)
+            dst[i] = quantize(src[i], scale);
+
+        return;
+    }
+
+    convert("i8_pack", m_context.get_features().storage_buffer_8bit, 4,
+        in, out, in.elements(), scale);
+}
@@ -0,0 +1,17 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Embedded.h"
+
+using namespace gcl;
+
+const embedded::Spirv* embedded::find(const std::string& name) {
+    for (const Spirv& spirv : kernels) {
+        if (name == spirv.name)
+            return &spirv;
+    }
+
+    return nullptr;
+}
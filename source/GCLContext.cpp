@@ -4,24 +4,156 @@
 //
 
 #include "../include/GCLContext.h"
+#include "../include/Host.h"
+#include "../include/Trace.h"
 
 #define VMA_IMPLEMENTATION
 #include "../vendor/vma.h"
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstdint>
 #include <iostream>
 #include <set>
+#include <string>
 #include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 using namespace gcl;
 
+/// The maximum number of compute queues a context will create.
+static constexpr uint32_t MAX_COMPUTE_QUEUES = 4;
+
+/// The default number of invocations under which dispatches go to the host.
+static constexpr uint64_t DEFAULT_HOST_THRESHOLD = 1 << 14;
+
+/// How long the fence waiter blocks before picking up new fences, in
+/// nanoseconds.
+static constexpr uint64_t WAITER_TIMEOUT_NS = 1'000'000;
+
+/// The default fraction of a heap's budget that allocations may fill before
+/// spilling to host memory.
+static constexpr double DEFAULT_SOFT_LIMIT = 0.9;
+
+/// Source of unique context identifiers.
+static std::atomic<uint64_t> g_next_context_id = 1;
+
+/// Caches the calling thread's command state per context, so that the 
+/// dispatch path only takes the context lock the first time a thread records.
+/// Identifiers are never reused, so entries of destroyed contexts are inert.
+static thread_local std::unordered_map<uint64_t, void*> t_commands;
+
 std::vector<const char*> EXTENSIONS = {
 #ifdef USE_VALIDATION_LAYERS
     VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
 #endif // USE_VALIDATION_LAYERS
 };
 
+/// Device extensions that are enabled when available, but not required.
+std::vector<const char*> OPTIONAL_DEVICE_EXTENSIONS = {
+    VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+    VK_KHR_EXTERNAL_FENCE_FD_EXTENSION_NAME,
+    VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME,
+};
+
+namespace gcl {
+
+/// A thread that waits on the fences of asynchronous submissions and signals
+/// an eventfd for each one that finishes, for devices that can't export
+/// fences as sync files.
+class FenceWaiter final {
+    VkDevice m_device;
+
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::vector<std::pair<VkFence, int>> m_pending;
+    bool m_stop = false;
+
+    std::thread m_thread;
+
+    /// Signal the eventfd |fd|.
+    static void signal(int fd) {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t res = ::write(fd, &one, sizeof(one));
+    }
+
+    void run() {
+        std::vector<VkFence> fences;
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_cv.wait(lock, [this]() {
+                    return m_stop || !m_pending.empty();
+                });
+
+                if (m_stop)
+                    break;
+
+                fences.clear();
+                for (const auto& [fence, fd] : m_pending)
+                    fences.push_back(fence);
+            }
+
+            // Wake up when any fence signals, or periodically to pick up
+            // fences watched in the meantime.
+            vkWaitForFences(m_device, fences.size(), fences.data(), VK_FALSE,
+                WAITER_TIMEOUT_NS);
+
+            // Entries are removed before they are signaled, so a completion
+            // that sees its descriptor signaled may reset the fence at once.
+            std::lock_guard<std::mutex> guard(m_lock);
+            std::erase_if(m_pending, [this](const auto& entry) {
+                if (vkGetFenceStatus(m_device, entry.first) != VK_SUCCESS)
+                    return false;
+
+                signal(entry.second);
+                return true;
+            });
+        }
+
+        // The device is idle once the context stops the waiter, so whatever
+        // is left has finished.
+        std::lock_guard<std::mutex> guard(m_lock);
+        for (const auto& [fence, fd] : m_pending)
+            signal(fd);
+
+        m_pending.clear();
+    }
+
+public:
+    FenceWaiter(VkDevice device) 
+            : m_device(device), m_thread([this]() { run(); }) {}
+
+    ~FenceWaiter() {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_stop = true;
+        }
+
+        m_cv.notify_one();
+        m_thread.join();
+    }
+
+    /// Signal the eventfd |fd| once |fence| is signaled.
+    void watch(VkFence fence, int fd) {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_pending.emplace_back(fence, fd);
+        }
+
+        m_cv.notify_one();
+    }
+};
+
+} // namespace gcl
+
 #ifdef USE_VALIDATION_LAYERS
 
 #include <cstring>
@@ -87,9 +219,33 @@ static bool has_extension_support(VkPhysicalDevice device) {
     return required.empty();
 }
 
+/// Returns the subset of |extensions| that a physical device supports.
+static std::vector<const char*> get_supported_extensions(
+        VkPhysicalDevice device, const std::vector<const char*>& extensions) {
+    uint32_t num_extensions;
+    vkEnumerateDeviceExtensionProperties(
+        device, nullptr, &num_extensions, nullptr);
+
+    std::vector<VkExtensionProperties> available(num_extensions);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &num_extensions, 
+        available.data());
+
+    std::set<std::string> names;
+    for (const auto& extension : available)
+        names.insert(extension.extensionName);
+
+    std::vector<const char*> supported;
+    for (const char* extension : extensions) {
+        if (names.count(extension) != 0)
+            supported.push_back(extension);
+    }
+
+    return supported;
+}
+
 /// Finds and returns the index of a queue family that supports compute.
 static std::optional<uint32_t> find_compute_queue_index(
-        VkPhysicalDevice device) {
+        VkPhysicalDevice device, uint32_t* num_queues) {
     uint32_t num_families;
     vkGetPhysicalDeviceQueueFamilyProperties(device, &num_families, nullptr);
 
@@ -103,6 +259,7 @@ static std::optional<uint32_t> find_compute_queue_index(
     for (const auto& family : families) {
         if (family.queueFlags & VK_QUEUE_COMPUTE_BIT) {
             index = iter;
+            *num_queues = family.queueCount;
             break;
         }
 
@@ -112,33 +269,69 @@ static std::optional<uint32_t> find_compute_queue_index(
     return index;
 }
 
-GCLContext::GCLContext() {
-    init_vulkan_instance();
-    init_vulkan_physical_device();
-    init_vulkan_logical_device();
-    init_vulkan_sync_structures();
-    init_vulkan_commands();
-    init_vma_allocator();
+GCLContext::GCLContext(Backend backend) 
+        : m_id(g_next_context_id++), 
+          m_host_threshold(DEFAULT_HOST_THRESHOLD),
+          m_soft_limit(DEFAULT_SOFT_LIMIT) {
+    if (backend == Backend::Host) {
+        m_host = true;
+        return;
+    }
+
+    try {
+        init_vulkan_instance();
+        init_vulkan_physical_device();
+        init_vulkan_logical_device();
+        init_vma_allocator();
+    } catch (const rt_error& e) {
+        destroy();
+        if (backend == Backend::Device)
+            throw;
+
+#ifdef USE_VERBOSE_LOGGING
+        std::cout << "no usable device, running on host: " << e.what() 
+            << '\n';
+#endif // USE_VERBOSE_LOGGING
+
+        m_host = true;
+        return;
+    }
+
+    // Tune from the cached profile, if this device has been probed before.
+    if (std::optional<DeviceProfile> profile = load_profile(*this))
+        set_profile(*profile);
 }
 
 GCLContext::~GCLContext() {
-     if (m_device != nullptr)
+    destroy();
+}
+
+void GCLContext::destroy() {
+    if (m_device != nullptr)
         vkDeviceWaitIdle(m_device);
 
-    if (m_cmd != nullptr) {
-        vkFreeCommandBuffers(m_device, m_pool, 1, &m_cmd);
-        m_cmd = nullptr;
-    }
+    m_waiter.reset();
+    m_fence_fd = false;
+    m_get_fence_fd = nullptr;
+    m_import_alignment = 0;
+    m_get_host_pointer_props = nullptr;
 
-    if (m_pool != nullptr) {
-        vkDestroyCommandPool(m_device, m_pool, nullptr);
-        m_pool = nullptr;
+    for (auto& commands : m_commands) {
+        // Destroying the pool also frees the command buffers allocated from
+        // it.
+        vkDestroyCommandPool(m_device, commands->pool, nullptr);
     }
 
-    if (m_fence != nullptr) {
-        vkDestroyFence(m_device, m_fence, nullptr);
-        m_fence = nullptr;
-    }
+    m_commands.clear();
+
+    for (VkFence fence : m_fences)
+        vkDestroyFence(m_device, fence, nullptr);
+
+    m_fences.clear();
+    m_free_fences.clear();
+    m_queues.clear();
+    m_device_extensions.clear();
+    m_features = {};
     
     if (m_allocator != nullptr) {
         vmaDestroyAllocator(m_allocator);
@@ -151,11 +344,17 @@ GCLContext::~GCLContext() {
     }
 
 #ifdef USE_VALIDATION_LAYERS
-    auto destroy_fn = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>( 
-        vkGetInstanceProcAddr(m_instance, "vkDestroyDebugUtilsMessengerEXT"));
+    if (m_instance != nullptr && m_msger != nullptr) {
+        auto destroy_fn = 
+            reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>( 
+                vkGetInstanceProcAddr(
+                    m_instance, "vkDestroyDebugUtilsMessengerEXT"));
 
-    if (destroy_fn) 
-        destroy_fn(m_instance, m_msger, nullptr);
+        if (destroy_fn) 
+            destroy_fn(m_instance, m_msger, nullptr);
+
+        m_msger = nullptr;
+    }
 #endif // USE_VALIDATION_LAYERS
 
     if (m_instance != nullptr) {
@@ -249,26 +448,70 @@ void GCLContext::init_vulkan_physical_device() {
 }
 
 void GCLContext::init_vulkan_logical_device() {
+    uint32_t num_queues = 0;
     std::optional<uint32_t> compute_index = 
-        find_compute_queue_index(m_physical_device);
+        find_compute_queue_index(m_physical_device, &num_queues);
 
     if (!compute_index.has_value())
         throw rt_error("physical device not support a compute queue.");
 
-    float queue_prio = 1.f;
+    num_queues = std::clamp(num_queues, 1u, MAX_COMPUTE_QUEUES);
+
+    std::vector<float> queue_prios(num_queues, 1.f);
     VkDeviceQueueCreateInfo queue_info {};
     queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queue_info.queueFamilyIndex = *compute_index;
-    queue_info.queueCount = 1;
-    queue_info.pQueuePriorities = &queue_prio;
+    queue_info.queueCount = num_queues;
+    queue_info.pQueuePriorities = queue_prios.data();
     
+    // Query the optional features first, so that only supported ones are
+    // requested.
+    VkPhysicalDeviceVulkan11Features supported11 {};
+    supported11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+
+    VkPhysicalDeviceVulkan12Features supported12 {};
+    supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    supported12.pNext = &supported11;
+
+    VkPhysicalDeviceFeatures2 supported {};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported.pNext = &supported12;
+
+    vkGetPhysicalDeviceFeatures2(m_physical_device, &supported);
+
+    m_features.storage_buffer_16bit = supported11.storageBuffer16BitAccess;
+    m_features.storage_buffer_8bit = supported12.storageBuffer8BitAccess;
+    m_features.shader_float16 = supported12.shaderFloat16;
+    m_features.shader_int8 = supported12.shaderInt8;
+
+    VkPhysicalDeviceSubgroupProperties subgroup {};
+    subgroup.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 props {};
+    props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    props.pNext = &subgroup;
+
+    vkGetPhysicalDeviceProperties2(m_physical_device, &props);
+
+    m_features.subgroup_arithmetic = 
+        (subgroup.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT)
+        && (subgroup.supportedOperations & VK_SUBGROUP_FEATURE_ARITHMETIC_BIT);
+    m_features.subgroup_size = std::max(1u, subgroup.subgroupSize);
+
     VkPhysicalDeviceFeatures core {};
     // no core features needed.
+
+    VkPhysicalDeviceVulkan11Features v11 {};
+    v11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+    v11.storageBuffer16BitAccess = m_features.storage_buffer_16bit;
     
     VkPhysicalDeviceVulkan12Features v12 {};
     v12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
     v12.bufferDeviceAddress = VK_TRUE;
     v12.descriptorIndexing = VK_TRUE;
+    v12.storageBuffer8BitAccess = m_features.storage_buffer_8bit;
+    v12.shaderFloat16 = m_features.shader_float16;
+    v12.shaderInt8 = m_features.shader_int8;
 
     VkPhysicalDeviceVulkan13Features v13 {};
     v13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
@@ -280,55 +523,473 @@ void GCLContext::init_vulkan_logical_device() {
     feats.pNext = &v13;
 
     v13.pNext = &v12;
+    v12.pNext = &v11;
+
+    std::vector<const char*> extensions = get_supported_extensions(
+        m_physical_device, OPTIONAL_DEVICE_EXTENSIONS);
 
     VkDeviceCreateInfo device_info {};
     device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     device_info.queueCreateInfoCount = 1;
     device_info.pQueueCreateInfos = &queue_info;
+    device_info.enabledExtensionCount = extensions.size();
+    device_info.ppEnabledExtensionNames = extensions.data();
     device_info.pNext = &feats;
 
     VK_CHECK(vkCreateDevice(
         m_physical_device, &device_info, nullptr, &m_device));
 
-    // Get the compute queue we asked for.
-    vkGetDeviceQueue(m_device, *compute_index, 0, &m_queue);
+    m_device_extensions.insert(extensions.begin(), extensions.end());
+
+    // Completions are exported as sync files if the device can export them,
+    // otherwise they fall back to a waiter thread.
+    if (has_device_extension(VK_KHR_EXTERNAL_FENCE_FD_EXTENSION_NAME)) {
+        VkPhysicalDeviceExternalFenceInfo fence_info {};
+        fence_info.sType = 
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_FENCE_INFO;
+        fence_info.handleType = VK_EXTERNAL_FENCE_HANDLE_TYPE_SYNC_FD_BIT;
+
+        VkExternalFenceProperties fence_props {};
+        fence_props.sType = VK_STRUCTURE_TYPE_EXTERNAL_FENCE_PROPERTIES;
+        vkGetPhysicalDeviceExternalFenceProperties(
+            m_physical_device, &fence_info, &fence_props);
+
+        m_get_fence_fd = reinterpret_cast<PFN_vkGetFenceFdKHR>(
+            vkGetDeviceProcAddr(m_device, "vkGetFenceFdKHR"));
+        m_fence_fd = m_get_fence_fd != nullptr 
+            && (fence_props.externalFenceFeatures 
+                & VK_EXTERNAL_FENCE_FEATURE_EXPORTABLE_BIT);
+    }
+
+    // Host memory can be imported if the device supports it, otherwise it
+    // has to be copied into buffers.
+    if (has_device_extension(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME)) {
+        VkPhysicalDeviceExternalMemoryHostPropertiesEXT host_props {};
+        host_props.sType = 
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+
+        VkPhysicalDeviceProperties2 props2 {};
+        props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        props2.pNext = &host_props;
+        vkGetPhysicalDeviceProperties2(m_physical_device, &props2);
+
+        m_get_host_pointer_props = 
+            reinterpret_cast<PFN_vkGetMemoryHostPointerPropertiesEXT>(
+                vkGetDeviceProcAddr(
+                    m_device, "vkGetMemoryHostPointerPropertiesEXT"));
+        if (m_get_host_pointer_props != nullptr) {
+            m_import_alignment = 
+                host_props.minImportedHostPointerAlignment;
+        }
+    }
+
+    // Get the compute queues we asked for.
+    for (uint32_t idx = 0; idx < num_queues; ++idx) {
+        auto queue = std::make_unique<ComputeQueue>();
+        vkGetDeviceQueue(m_device, *compute_index, idx, &queue->queue);
+        m_queues.push_back(std::move(queue));
+    }
+
     m_qfamily = *compute_index;
 }
 
-void GCLContext::init_vulkan_sync_structures() {
-    VkFenceCreateInfo fence_info {};
-    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    
-    VK_CHECK(vkCreateFence(m_device, &fence_info, nullptr, &m_fence));
+void GCLContext::init_vma_allocator() {
+    VmaAllocatorCreateInfo info {};
+    info.physicalDevice = m_physical_device;
+    info.device = m_device;
+    info.instance = m_instance;
+    info.vulkanApiVersion = VK_API_VERSION_1_3;
+    info.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+
+    if (has_device_extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+        info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+
+    VmaVulkanFunctions funcs {};
+    funcs.vkGetInstanceProcAddr = vkGetInstanceProcAddr;
+    funcs.vkGetDeviceProcAddr = vkGetDeviceProcAddr;
+    info.pVulkanFunctions = &funcs;
+
+    VK_CHECK(vmaCreateAllocator(&info, &m_allocator));
 }
 
-void GCLContext::init_vulkan_commands() {
+GCLContext::ThreadCommands& GCLContext::get_thread_commands() {
+    auto it = t_commands.find(m_id);
+    if (it != t_commands.end())
+        return *static_cast<ThreadCommands*>(it->second);
+
+    auto commands = std::make_unique<ThreadCommands>();
+    commands->queue = m_next_queue++ % m_queues.size();
+
     VkCommandPoolCreateInfo pool_info {};
     pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_info.queueFamilyIndex = m_qfamily;
 
-    VK_CHECK(vkCreateCommandPool(m_device, &pool_info, nullptr, &m_pool));
+    VK_CHECK(vkCreateCommandPool(
+        m_device, &pool_info, nullptr, &commands->pool));
 
     VkCommandBufferAllocateInfo alloc_info {};
     alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    alloc_info.commandPool = m_pool;
+    alloc_info.commandPool = commands->pool;
     alloc_info.commandBufferCount = 1;
     alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-    VK_CHECK(vkAllocateCommandBuffers(m_device, &alloc_info, &m_cmd));
+    VkResult res = vkAllocateCommandBuffers(
+        m_device, &alloc_info, &commands->cmd);
+    if (res != VK_SUCCESS) {
+        vkDestroyCommandPool(m_device, commands->pool, nullptr);
+        VK_CHECK(res);
+    }
+
+    ThreadCommands* ptr = commands.get();
+    {
+        std::lock_guard<std::mutex> guard(m_commands_lock);
+        m_commands.push_back(std::move(commands));
+    }
+
+    t_commands[m_id] = ptr;
+    return *ptr;
 }
 
-void GCLContext::init_vma_allocator() {
-    VmaAllocatorCreateInfo info {};
-    info.physicalDevice = m_physical_device;
-    info.device = m_device;
-    info.instance = m_instance;
-    info.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+VkFence GCLContext::acquire_fence() {
+    {
+        std::lock_guard<std::mutex> guard(m_fences_lock);
+        if (!m_free_fences.empty()) {
+            VkFence fence = m_free_fences.back();
+            m_free_fences.pop_back();
+            return fence;
+        }
+    }
 
-    VmaVulkanFunctions funcs {};
-    funcs.vkGetInstanceProcAddr = vkGetInstanceProcAddr;
-    funcs.vkGetDeviceProcAddr = vkGetDeviceProcAddr;
-    info.pVulkanFunctions = &funcs;
+    VkExportFenceCreateInfo export_info {};
+    export_info.sType = VK_STRUCTURE_TYPE_EXPORT_FENCE_CREATE_INFO;
+    export_info.handleTypes = VK_EXTERNAL_FENCE_HANDLE_TYPE_SYNC_FD_BIT;
 
-    VK_CHECK(vmaCreateAllocator(&info, &m_allocator));
+    VkFenceCreateInfo fence_info {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_info.pNext = m_fence_fd ? &export_info : nullptr;
+
+    VkFence fence = nullptr;
+    VK_CHECK(vkCreateFence(m_device, &fence_info, nullptr, &fence));
+
+    std::lock_guard<std::mutex> guard(m_fences_lock);
+    m_fences.push_back(fence);
+    return fence;
+}
+
+void GCLContext::release_fence(VkFence fence) {
+    std::lock_guard<std::mutex> guard(m_fences_lock);
+    m_free_fences.push_back(fence);
+}
+
+void GCLContext::submit(VkCommandBuffer cmd) {
+    if (m_host)
+        throw rt_error("cannot submit commands to a host context.");
+
+    ComputeQueue& queue = *m_queues[get_thread_commands().queue];
+
+    VkSubmitInfo submit {};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &cmd;
+
+    VkFence fence = acquire_fence();
+
+    VkResult res;
+    {
+        GCL_TIMED_SCOPE("vkQueueSubmit", SubmitNs);
+        GCL_COUNT(Submits, 1);
+
+        // Queues are externally synchronized, but only for the duration of
+        // the submission itself; waiting happens outside of the lock.
+        std::lock_guard<std::mutex> guard(queue.lock);
+        res = vkQueueSubmit(queue.queue, 1, &submit, fence);
+    }
+
+    if (res == VK_SUCCESS) {
+        GCL_TIMED_SCOPE("vkWaitForFences", FenceWaitNs);
+        res = vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX);
+    }
+
+    if (res == VK_SUCCESS) {
+        res = vkResetFences(m_device, 1, &fence);
+        if (res == VK_SUCCESS)
+            release_fence(fence);
+    }
+
+    VK_CHECK(res);
+}
+
+VkCommandBuffer GCLContext::acquire_command_buffer() {
+    ThreadCommands& commands = get_thread_commands();
+
+    VkCommandBuffer cmd = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(commands.free_lock);
+        if (!commands.free.empty()) {
+            cmd = commands.free.back();
+            commands.free.pop_back();
+        }
+    }
+
+    if (cmd != nullptr) {
+        VK_CHECK(vkResetCommandBuffer(cmd, 0));
+        return cmd;
+    }
+
+    VkCommandBufferAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = commands.pool;
+    alloc_info.commandBufferCount = 1;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+    VK_CHECK(vkAllocateCommandBuffers(m_device, &alloc_info, &cmd));
+    return cmd;
+}
+
+void GCLContext::release_command_buffer(VkCommandPool pool, 
+                                        VkCommandBuffer cmd) {
+    std::lock_guard<std::mutex> guard(m_commands_lock);
+    for (auto& commands : m_commands) {
+        if (commands->pool != pool)
+            continue;
+
+        std::lock_guard<std::mutex> free_guard(commands->free_lock);
+        commands->free.push_back(cmd);
+        return;
+    }
+}
+
+Completion GCLContext::submit_async(VkCommandBuffer cmd, 
+                                    VkCommandPool pool) {
+    if (m_host)
+        throw rt_error("cannot submit commands to a host context.");
+
+    ComputeQueue& queue = *m_queues[get_thread_commands().queue];
+
+    VkSubmitInfo submit {};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &cmd;
+
+    VkFence fence = acquire_fence();
+
+    VkResult res;
+    {
+        GCL_TIMED_SCOPE("vkQueueSubmit", SubmitNs);
+        GCL_COUNT(Submits, 1);
+
+        std::lock_guard<std::mutex> guard(queue.lock);
+        res = vkQueueSubmit(queue.queue, 1, &submit, fence);
+    }
+
+    if (res != VK_SUCCESS) {
+        release_fence(fence);
+        if (pool != nullptr)
+            release_command_buffer(pool, cmd);
+
+        VK_CHECK(res);
+    }
+
+    if (m_fence_fd) {
+        VkFenceGetFdInfoKHR fd_info {};
+        fd_info.sType = VK_STRUCTURE_TYPE_FENCE_GET_FD_INFO_KHR;
+        fd_info.fence = fence;
+        fd_info.handleType = VK_EXTERNAL_FENCE_HANDLE_TYPE_SYNC_FD_BIT;
+
+        int fd = -1;
+        VK_CHECK(m_get_fence_fd(m_device, &fd_info, &fd));
+
+        // The driver may return -1 for a fence that has already signaled.
+        if (fd < 0)
+            fd = ::eventfd(1, EFD_CLOEXEC);
+        if (fd < 0)
+            throw rt_error("failed to create completion descriptor.");
+
+        return Completion(this, pool, cmd, fence, fd, true);
+    }
+
+    int fd = ::eventfd(0, EFD_CLOEXEC);
+    if (fd < 0)
+        throw rt_error("failed to create completion descriptor.");
+
+    {
+        std::lock_guard<std::mutex> guard(m_waiter_lock);
+        if (m_waiter == nullptr)
+            m_waiter = std::make_unique<FenceWaiter>(m_device);
+    }
+
+    m_waiter->watch(fence, fd);
+    return Completion(this, pool, cmd, fence, fd, false);
+}
+
+void GCLContext::set_profile(const DeviceProfile& profile) {
+    m_profile = profile;
+    if (!profile.is_measured())
+        return;
+
+    m_host_threshold.store(profile.host_threshold);
+    if (profile.host_grain != 0)
+        host::set_grain(profile.host_grain);
+}
+
+bool GCLContext::has_device_extension(const std::string& name) const {
+    return m_device_extensions.count(name) != 0;
+}
+
+std::vector<HeapBudget> GCLContext::get_memory_budgets() const {
+    if (m_host)
+        return {};
+
+    VkPhysicalDeviceMemoryProperties props;
+    vkGetPhysicalDeviceMemoryProperties(m_physical_device, &props);
+
+    std::vector<VmaBudget> budgets(props.memoryHeapCount);
+    vmaGetHeapBudgets(m_allocator, budgets.data());
+
+    std::vector<HeapBudget> heaps(props.memoryHeapCount);
+    for (uint32_t idx = 0; idx < props.memoryHeapCount; ++idx) {
+        const VkMemoryHeap& heap = props.memoryHeaps[idx];
+
+        heaps[idx].heap = idx;
+        heaps[idx].device_local = 
+            (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        heaps[idx].size = heap.size;
+        heaps[idx].budget = budgets[idx].budget;
+        heaps[idx].usage = budgets[idx].usage;
+        heaps[idx].block_bytes = budgets[idx].statistics.blockBytes;
+        heaps[idx].allocation_bytes = 
+            budgets[idx].statistics.allocationBytes;
+    }
+
+    return heaps;
+}
+
+void GCLContext::import_host_memory(void* host, 
+                                    const VkBufferCreateInfo& info,
+                                    VkBuffer* buf, VkDeviceMemory* memory) {
+    if (m_import_alignment == 0)
+        throw rt_error("the device can't import host memory.");
+
+    VkDeviceSize size = (info.size + m_import_alignment - 1) 
+        & ~(m_import_alignment - 1);
+    if (reinterpret_cast<uintptr_t>(host) % m_import_alignment != 0)
+        throw rt_error("imported host memory is misaligned.");
+
+    const VkExternalMemoryHandleTypeFlagBits handle_type = 
+        VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+
+    VkMemoryHostPointerPropertiesEXT pointer_props {};
+    pointer_props.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+    VK_CHECK(m_get_host_pointer_props(
+        m_device, handle_type, host, &pointer_props));
+
+    VkExternalMemoryBufferCreateInfo external_info {};
+    external_info.sType = 
+        VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+    external_info.handleTypes = handle_type;
+
+    VkBufferCreateInfo buf_info = info;
+    buf_info.pNext = &external_info;
+    VK_CHECK(vkCreateBuffer(m_device, &buf_info, nullptr, buf));
+
+    VkMemoryRequirements reqs;
+    vkGetBufferMemoryRequirements(m_device, *buf, &reqs);
+
+    // The host keeps reading and writing the memory without flushing, so it
+    // has to be coherent.
+    const VkPhysicalDeviceMemoryProperties* props = nullptr;
+    vmaGetMemoryProperties(m_allocator, &props);
+
+    uint32_t type = UINT32_MAX;
+    uint32_t candidates = reqs.memoryTypeBits & pointer_props.memoryTypeBits;
+    for (uint32_t idx = 0; idx < props->memoryTypeCount; ++idx) {
+        VkMemoryPropertyFlags flags = props->memoryTypes[idx].propertyFlags;
+        if ((candidates & (1u << idx)) 
+              && (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            type = idx;
+            break;
+        }
+    }
+
+    if (type == UINT32_MAX) {
+        vkDestroyBuffer(m_device, *buf, nullptr);
+        throw rt_error("no coherent memory type for imported host memory.");
+    }
+
+    VkImportMemoryHostPointerInfoEXT import_info {};
+    import_info.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+    import_info.handleType = handle_type;
+    import_info.pHostPointer = host;
+
+    VkMemoryAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.pNext = &import_info;
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = type;
+
+    *memory = nullptr;
+    VkResult res = vkAllocateMemory(m_device, &alloc_info, nullptr, memory);
+    if (res == VK_SUCCESS)
+        res = vkBindBufferMemory(m_device, *buf, *memory, 0);
+
+    if (res != VK_SUCCESS) {
+        vkDestroyBuffer(m_device, *buf, nullptr);
+        if (*memory != nullptr)
+            vkFreeMemory(m_device, *memory, nullptr);
+
+        *buf = nullptr;
+        *memory = nullptr;
+        VK_CHECK(res);
+    }
+}
+
+bool GCLContext::create_buffer(const VkBufferCreateInfo& info, VkBuffer* buf,
+                               VmaAllocation* alloc) {
+    // Prefer host-visible device-local memory, as long as the heap it comes
+    // from stays under the soft limit.
+    VmaAllocationCreateInfo alloc_info {};
+    alloc_info.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    alloc_info.flags = VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+
+    bool under_limit = true;
+
+    uint32_t type = 0;
+    VkResult res = vmaFindMemoryTypeIndexForBufferInfo(
+        m_allocator, &info, &alloc_info, &type);
+    if (res == VK_SUCCESS) {
+        const VkPhysicalDeviceMemoryProperties* props = nullptr;
+        vmaGetMemoryProperties(m_allocator, &props);
+
+        uint32_t heap = props->memoryTypes[type].heapIndex;
+
+        std::vector<VmaBudget> budgets(props->memoryHeapCount);
+        vmaGetHeapBudgets(m_allocator, budgets.data());
+
+        double limit = m_soft_limit.load() * budgets[heap].budget;
+        under_limit = budgets[heap].usage + info.size <= limit;
+    }
+
+    if (under_limit) {
+        res = vmaCreateBuffer(
+            m_allocator, &info, &alloc_info, buf, alloc, nullptr);
+        if (res == VK_SUCCESS)
+            return false;
+
+        if (res != VK_ERROR_OUT_OF_DEVICE_MEMORY)
+            VK_CHECK(res);
+    }
+
+    // Spill to cached host memory that the device reads over the bus. This
+    // is slower to access from kernels, but keeps the device heap free.
+    alloc_info.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+    alloc_info.flags = 0;
+    alloc_info.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+    VK_CHECK(vmaCreateBuffer(
+        m_allocator, &info, &alloc_info, buf, alloc, nullptr));
+
+    ++m_spilled;
+    GCL_COUNT(SpilledAllocations, 1);
+    return true;
 }
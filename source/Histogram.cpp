@@ -0,0 +1,190 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Histogram.h"
+#include "../include/Embedded.h"
+#include "../include/Host.h"
+#include "../include/Trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+
+using namespace gcl;
+
+/// The most bins counted per pass, as in the histogram kernels.
+static constexpr uint32_t MAX_PASS_BINS = 4096;
+
+/// The most workgroups dispatched. Each workgroup merges its sub-histogram
+/// into the global counts, so fewer groups that loop over more values keep
+/// the atomics on the counts down. Fewer are used if the device profile says
+/// fewer saturate the device.
+static constexpr uint32_t MAX_GROUPS = 1024;
+
+/// Push constants of the histogram kernels.
+struct HistogramParams {
+    uint32_t n;
+    uint32_t bins;
+    uint32_t first_bin;
+    uint32_t pass_bins;
+    uint32_t uniform_edges;
+    float scale;
+};
+
+/// Returns |bins| + 1 evenly spaced edges over [|lo|, |hi|].
+template<typename T>
+static std::vector<T> make_edges(T lo, T hi, uint32_t bins) {
+    if (bins == 0)
+        throw rt_error("a histogram needs at least one bin.");
+
+    std::vector<T> edges(bins + 1);
+    for (uint32_t i = 0; i <= bins; ++i) {
+        if constexpr (std::is_floating_point_v<T>) {
+            edges[i] = static_cast<T>(
+                lo + (static_cast<double>(hi) - lo) * i / bins);
+        } else {
+            edges[i] = static_cast<T>(
+                lo + static_cast<uint64_t>(hi - lo) * i / bins);
+        }
+    }
+
+    // Don't let rounding move the upper edge.
+    edges[bins] = hi;
+    return edges;
+}
+
+/// Returns the bin of |v| in |edges|, or the number of bins if it's outside.
+template<typename T>
+static uint32_t find_bin(const std::vector<T>& edges, T v) {
+    uint32_t bins = static_cast<uint32_t>(edges.size() - 1);
+    if (!(v >= edges.front() && v <= edges.back()))
+        return bins;
+
+    auto it = std::upper_bound(edges.begin(), edges.end(), v);
+    uint32_t bin = static_cast<uint32_t>(it - edges.begin()) - 1;
+
+    // The upper edge belongs to the last bin.
+    return std::min(bin, bins - 1);
+}
+
+/// Returns the embedded histogram kernel for values of type T.
+template<typename T>
+static const embedded::Spirv& get_spirv() {
+    if constexpr (std::is_same_v<T, float>)
+        return embedded::histogram_f32;
+    else
+        return embedded::histogram_u32;
+}
+
+template<typename T>
+Histogram<T>::Histogram(GCLContext& context, const std::vector<T>& edges)
+        : m_context(context), m_edges(edges),
+          m_edge_buf(context, std::max<uint64_t>(edges.size(), 1)),
+          m_counts(context, std::max<uint64_t>(edges.size(), 2) - 1),
+          m_program(context) {
+    init();
+}
+
+template<typename T>
+Histogram<T>::Histogram(GCLContext& context, T lo, T hi, uint32_t bins)
+        : Histogram(context, make_edges(lo, hi, bins)) {
+    m_uniform = true;
+}
+
+template<typename T>
+void Histogram<T>::init() {
+    if (m_edges.size() < 2)
+        throw rt_error("a histogram needs at least one bin.");
+
+    for (size_t i = 1; i < m_edges.size(); ++i) {
+        if (!(m_edges[i - 1] < m_edges[i]))
+            throw rt_error("histogram edges must be strictly ascending.");
+    }
+
+    m_edge_buf.send(m_edges);
+
+    if (m_context.is_host())
+        return;
+
+    m_kernel = std::make_unique<Kernel>(m_context, get_spirv<T>());
+    m_kernel->bind(1, m_edge_buf);
+    m_kernel->bind(2, m_counts);
+}
+
+template<typename T>
+uint32_t Histogram<T>::get_passes() const {
+    return (get_bins() + MAX_PASS_BINS - 1) / MAX_PASS_BINS;
+}
+
+template<typename T>
+std::vector<uint32_t> Histogram<T>::compute(Buffer<T>& values, uint64_t n) {
+    uint64_t count = n == 0 ? values.elements() : n;
+    if (count > values.elements())
+        throw rt_error("histogram input is smaller than the value count.");
+
+    if (count > std::numeric_limits<uint32_t>::max())
+        throw rt_error("too many values for a single histogram.");
+
+    GCL_SCOPE("Histogram::compute");
+
+    const uint32_t bins = get_bins();
+
+    if (m_context.is_host()) {
+        const T* data = static_cast<const T*>(values.host_data());
+        std::vector<uint32_t> counts(bins, 0);
+        std::mutex lock;
+
+        host::parallel_for(count, [&](uint64_t begin, uint64_t end) {
+            std::vector<uint32_t> local(bins, 0);
+            for (uint64_t i = begin; i < end; ++i) {
+                uint32_t bin = find_bin(m_edges, data[i]);
+                if (bin < bins)
+                    ++local[bin];
+            }
+
+            std::lock_guard<std::mutex> guard(lock);
+            for (uint32_t bin = 0; bin < bins; ++bin)
+                counts[bin] += local[bin];
+        });
+
+        return counts;
+    }
+
+    m_counts.send(std::vector<uint32_t>(bins, 0));
+    if (count == 0)
+        return m_counts.fetch();
+
+    m_kernel->bind(0, values);
+
+    uint32_t local_size = m_kernel->get_local_size_x();
+    uint64_t groups = std::min<uint64_t>(
+        (count + local_size - 1) / local_size,
+        m_context.get_max_groups(MAX_GROUPS, local_size));
+
+    HistogramParams params {};
+    params.n = static_cast<uint32_t>(count);
+    params.bins = bins;
+    params.uniform_edges = m_uniform ? 1 : 0;
+    params.scale = static_cast<float>(bins
+        / (static_cast<double>(m_edges.back()) - m_edges.front()));
+
+    // The group count depends on |n|, so the passes are added anew.
+    m_program.clear();
+    for (uint32_t first = 0; first < bins; first += MAX_PASS_BINS) {
+        params.first_bin = first;
+        params.pass_bins = std::min(bins - first, MAX_PASS_BINS);
+
+        m_kernel->push(params);
+        m_program.add(*m_kernel, static_cast<uint32_t>(groups * local_size));
+    }
+
+    m_program.run();
+    return m_counts.fetch();
+}
+
+template class gcl::Histogram<float>;
+template class gcl::Histogram<uint32_t>;
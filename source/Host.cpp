@@ -0,0 +1,523 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Host.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define GCL_HOST_X86
+    #include <immintrin.h>
+#endif
+
+using namespace gcl;
+
+/// The default minimum number of invocations given to a single host thread.
+static constexpr uint64_t DEFAULT_GRAIN = 1 << 15;
+
+static std::atomic<uint64_t> g_grain = DEFAULT_GRAIN;
+
+namespace {
+
+/// A fixed set of worker threads that split a range between themselves and
+/// the thread that posted it.
+class ThreadPool final {
+    std::vector<std::thread> m_workers;
+
+    /// Held by the caller whose range is currently being processed.
+    std::mutex m_busy;
+
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    uint32_t m_active = 0;
+    bool m_stop = false;
+
+    const std::function<void(uint64_t, uint64_t)>* m_fn = nullptr;
+    uint64_t m_n = 0;
+    uint64_t m_chunk = 0;
+    uint64_t m_num_chunks = 0;
+    std::atomic<uint64_t> m_next_chunk = 0;
+
+    /// Claim and process chunks of the current range until none are left.
+    void work() {
+        uint64_t chunk;
+        while ((chunk = m_next_chunk++) < m_num_chunks) {
+            uint64_t begin = chunk * m_chunk;
+            (*m_fn)(begin, std::min(m_n, begin + m_chunk));
+        }
+    }
+
+    void worker() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_wake.wait(lock, [&]() {
+                    return m_stop || m_generation != seen;
+                });
+
+                if (m_stop)
+                    return;
+
+                seen = m_generation;
+            }
+
+            work();
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (--m_active == 0)
+                m_done.notify_one();
+        }
+    }
+
+public:
+    ThreadPool(uint32_t num_workers) {
+        for (uint32_t idx = 0; idx < num_workers; ++idx)
+            m_workers.emplace_back([this]() { worker(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_stop = true;
+        }
+
+        m_wake.notify_all();
+        for (auto& worker : m_workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    void operator=(const ThreadPool&) = delete;
+
+    uint32_t size() const { return m_workers.size() + 1; }
+
+    /// Process [0, n) in chunks of |chunk| with the workers and the caller.
+    /// Returns false without doing anything if the pool is already in use.
+    bool try_run(uint64_t n, uint64_t chunk,
+                 const std::function<void(uint64_t, uint64_t)>& fn) {
+        std::unique_lock<std::mutex> busy(m_busy, std::try_to_lock);
+        if (!busy.owns_lock())
+            return false;
+
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_fn = &fn;
+            m_n = n;
+            m_chunk = chunk;
+            m_num_chunks = (n + chunk - 1) / chunk;
+            m_next_chunk = 0;
+            m_active = m_workers.size();
+            ++m_generation;
+        }
+
+        m_wake.notify_all();
+        work();
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_done.wait(lock, [&]() { return m_active == 0; });
+        return true;
+    }
+};
+
+} // namespace
+
+static ThreadPool& get_pool() {
+    static ThreadPool pool(
+        std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+host::Isa host::detect_isa() {
+#ifdef GCL_HOST_X86
+    static const Isa isa = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return Isa::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return Isa::AVX2;
+        return Isa::Scalar;
+    }();
+
+    return isa;
+#else
+    return Isa::Scalar;
+#endif // GCL_HOST_X86
+}
+
+const char* host::to_string(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar:
+        return "scalar";
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::AVX512:
+        return "avx512";
+    }
+
+    return "unknown";
+}
+
+uint32_t host::get_num_threads() {
+    return get_pool().size();
+}
+
+uint64_t host::get_grain() {
+    return g_grain.load(std::memory_order_relaxed);
+}
+
+void host::set_grain(uint64_t grain) {
+    g_grain.store(std::max<uint64_t>(1, grain), std::memory_order_relaxed);
+}
+
+void host::parallel_for(uint64_t n,
+                        const std::function<void(uint64_t, uint64_t)>& fn) {
+    if (n == 0)
+        return;
+
+    ThreadPool& pool = get_pool();
+
+    // Split into a few chunks per thread so uneven chunks even out, but never
+    // into chunks smaller than the grain.
+    uint64_t chunk = std::max(get_grain(), (n + pool.size() * 4 - 1)
+        / (pool.size() * 4));
+
+    if (n <= chunk || !pool.try_run(n, chunk, fn))
+        fn(0, n);
+}
+
+void host::run(KernelFn fn, void* const* bindings, uint64_t n) {
+    parallel_for(n, [&](uint64_t begin, uint64_t end) {
+        fn(bindings, begin, end);
+    });
+}
+
+//
+// Kernel implementations. Each kernel has a scalar version, and on x86 an
+// AVX2 and AVX-512 version that are selected at runtime by detect_isa().
+// These must produce the same results as the shaders in kernels/, and
+// each other, so every multiply-add is fused as in the SIMD versions.
+//
+
+using BinaryFn = void (*)(const float*, const float*, float*, uint64_t,
+                          uint64_t);
+
+static BinaryFn select(BinaryFn scalar, BinaryFn avx2, BinaryFn avx512) {
+    switch (host::detect_isa()) {
+    case host::Isa::AVX512:
+        return avx512;
+    case host::Isa::AVX2:
+        return avx2;
+    case host::Isa::Scalar:
+        break;
+    }
+
+    return scalar;
+}
+
+static void ma_scalar(const float* a, const float* b, float* r,
+                      uint64_t begin, uint64_t end) {
+    for (uint64_t i = begin; i < end; ++i)
+        r[i] = std::fma(a[i], b[i], 1.f);
+}
+
+static inline float branch_scalar_one(float av, float bv) {
+    if (av > 0.5f)
+        return std::fma(std::sqrt(av), bv, 1.f);
+    else if (av > 0.25f)
+        return std::fma(av, bv, -0.5f);
+    else
+        return (av + 0.001f) * (bv - 0.001f);
+}
+
+static void branch_scalar(const float* a, const float* b, float* r,
+                          uint64_t begin, uint64_t end) {
+    for (uint64_t i = begin; i < end; ++i)
+        r[i] = branch_scalar_one(a[i], b[i]);
+}
+
+static inline float poly_scalar(float x, float y) {
+    float acc = 0.f;
+
+    acc = std::fma(x, y, acc);
+    acc = std::fma(x * x, 0.25f, acc);
+    acc = std::fma(y * y, 0.125f, acc);
+    acc = std::fma(x * y, 0.0625f, acc);
+    acc = std::fma(x + y, 0.03125f, acc);
+
+    for (uint32_t i = 0; i < 8; ++i)
+        acc = std::fma(acc, 0.985123f, 0.314159f);
+
+    return acc;
+}
+
+static void heavy_scalar(const float* a, const float*, float* r,
+                         uint64_t begin, uint64_t end) {
+    // The shader reads |a| for both operands, so |b| is unused here too.
+    for (uint64_t i = begin; i < end; ++i) {
+        float x = a[i];
+        float y = a[i];
+
+        if ((i & 7) < 3)
+            r[i] = poly_scalar(x, y);
+        else
+            r[i] = poly_scalar(x * 0.5f, y * 1.5f);
+    }
+}
+
+#ifdef GCL_HOST_X86
+
+#define GCL_AVX2 __attribute__((target("avx2,fma")))
+#define GCL_AVX512 __attribute__((target("avx512f")))
+
+GCL_AVX2 static void ma_avx2(const float* a, const float* b, float* r,
+                             uint64_t begin, uint64_t end) {
+    const __m256 one = _mm256_set1_ps(1.f);
+
+    uint64_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 av = _mm256_loadu_ps(a + i);
+        __m256 bv = _mm256_loadu_ps(b + i);
+        _mm256_storeu_ps(r + i, _mm256_fmadd_ps(av, bv, one));
+    }
+
+    ma_scalar(a, b, r, i, end);
+}
+
+GCL_AVX512 static void ma_avx512(const float* a, const float* b, float* r,
+                                 uint64_t begin, uint64_t end) {
+    const __m512 one = _mm512_set1_ps(1.f);
+
+    for (uint64_t i = begin; i < end; i += 16) {
+        __mmask16 m = end - i >= 16 ? 0xffff : (1u << (end - i)) - 1;
+        __m512 av = _mm512_maskz_loadu_ps(m, a + i);
+        __m512 bv = _mm512_maskz_loadu_ps(m, b + i);
+        _mm512_mask_storeu_ps(r + i, m, _mm512_fmadd_ps(av, bv, one));
+    }
+}
+
+GCL_AVX2 static void branch_avx2(const float* a, const float* b, float* r,
+                                 uint64_t begin, uint64_t end) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    const __m256 eps = _mm256_set1_ps(0.001f);
+    const __m256 one = _mm256_set1_ps(1.f);
+
+    uint64_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 av = _mm256_loadu_ps(a + i);
+        __m256 bv = _mm256_loadu_ps(b + i);
+
+        // Evaluate every arm and blend, the sqrt of the lanes that are
+        // not taken is discarded.
+        __m256 hi = _mm256_fmadd_ps(_mm256_sqrt_ps(av), bv, one);
+        __m256 mid = _mm256_fmsub_ps(av, bv, half);
+        __m256 lo = _mm256_mul_ps(
+            _mm256_add_ps(av, eps), _mm256_sub_ps(bv, eps));
+
+        __m256 gt_half = _mm256_cmp_ps(av, half, _CMP_GT_OQ);
+        __m256 gt_quarter = _mm256_cmp_ps(av, quarter, _CMP_GT_OQ);
+
+        __m256 res = _mm256_blendv_ps(lo, mid, gt_quarter);
+        _mm256_storeu_ps(r + i, _mm256_blendv_ps(res, hi, gt_half));
+    }
+
+    branch_scalar(a, b, r, i, end);
+}
+
+GCL_AVX512 static void branch_avx512(const float* a, const float* b,
+                                     float* r, uint64_t begin,
+                                     uint64_t end) {
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 quarter = _mm512_set1_ps(0.25f);
+    const __m512 eps = _mm512_set1_ps(0.001f);
+    const __m512 one = _mm512_set1_ps(1.f);
+
+    for (uint64_t i = begin; i < end; i += 16) {
+        __mmask16 m = end - i >= 16 ? 0xffff : (1u << (end - i)) - 1;
+        __m512 av = _mm512_maskz_loadu_ps(m, a + i);
+        __m512 bv = _mm512_maskz_loadu_ps(m, b + i);
+
+        __m512 hi = _mm512_fmadd_ps(_mm512_sqrt_ps(av), bv, one);
+        __m512 mid = _mm512_fmsub_ps(av, bv, half);
+        __m512 lo = _mm512_mul_ps(
+            _mm512_add_ps(av, eps), _mm512_sub_ps(bv, eps));
+
+        __mmask16 gt_half = _mm512_cmp_ps_mask(av, half, _CMP_GT_OQ);
+        __mmask16 gt_quarter = _mm512_cmp_ps_mask(av, quarter, _CMP_GT_OQ);
+
+        __m512 res = _mm512_mask_blend_ps(gt_quarter, lo, mid);
+        res = _mm512_mask_blend_ps(gt_half, res, hi);
+        _mm512_mask_storeu_ps(r + i, m, res);
+    }
+}
+
+GCL_AVX2 static inline __m256 poly_avx2(__m256 x, __m256 y) {
+    __m256 acc = _mm256_mul_ps(x, y);
+    acc = _mm256_fmadd_ps(_mm256_mul_ps(x, x), _mm256_set1_ps(0.25f), acc);
+    acc = _mm256_fmadd_ps(_mm256_mul_ps(y, y), _mm256_set1_ps(0.125f), acc);
+    acc = _mm256_fmadd_ps(_mm256_mul_ps(x, y), _mm256_set1_ps(0.0625f), acc);
+    acc = _mm256_fmadd_ps(_mm256_add_ps(x, y), _mm256_set1_ps(0.03125f), acc);
+
+    const __m256 mul = _mm256_set1_ps(0.985123f);
+    const __m256 add = _mm256_set1_ps(0.314159f);
+    for (uint32_t i = 0; i < 8; ++i)
+        acc = _mm256_fmadd_ps(acc, mul, add);
+
+    return acc;
+}
+
+GCL_AVX2 static void heavy_avx2(const float* a, const float* b, float* r,
+                                uint64_t begin, uint64_t end) {
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i seven = _mm256_set1_epi32(7);
+    const __m256i three = _mm256_set1_epi32(3);
+
+    uint64_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 x = _mm256_loadu_ps(a + i);
+
+        __m256 p0 = poly_avx2(x, x);
+        __m256 p1 = poly_avx2(
+            _mm256_mul_ps(x, _mm256_set1_ps(0.5f)),
+            _mm256_mul_ps(x, _mm256_set1_ps(1.5f)));
+
+        // Lanes whose global index has (i & 7) < 3 take the first variant.
+        __m256i idx = _mm256_add_epi32(
+            _mm256_set1_epi32(static_cast<int32_t>(i)), lanes);
+        __m256i first = _mm256_cmpgt_epi32(
+            three, _mm256_and_si256(idx, seven));
+
+        _mm256_storeu_ps(
+            r + i, _mm256_blendv_ps(p1, p0, _mm256_castsi256_ps(first)));
+    }
+
+    heavy_scalar(a, b, r, i, end);
+}
+
+GCL_AVX512 static inline __m512 poly_avx512(__m512 x, __m512 y) {
+    __m512 acc = _mm512_mul_ps(x, y);
+    acc = _mm512_fmadd_ps(_mm512_mul_ps(x, x), _mm512_set1_ps(0.25f), acc);
+    acc = _mm512_fmadd_ps(_mm512_mul_ps(y, y), _mm512_set1_ps(0.125f), acc);
+    acc = _mm512_fmadd_ps(_mm512_mul_ps(x, y), _mm512_set1_ps(0.0625f), acc);
+    acc = _mm512_fmadd_ps(_mm512_add_ps(x, y), _mm512_set1_ps(0.03125f), acc);
+
+    const __m512 mul = _mm512_set1_ps(0.985123f);
+    const __m512 add = _mm512_set1_ps(0.314159f);
+    for (uint32_t i = 0; i < 8; ++i)
+        acc = _mm512_fmadd_ps(acc, mul, add);
+
+    return acc;
+}
+
+GCL_AVX512 static void heavy_avx512(const float* a, const float*, float* r,
+                                    uint64_t begin, uint64_t end) {
+    const __m512i lanes = _mm512_setr_epi32(
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i seven = _mm512_set1_epi32(7);
+    const __m512i three = _mm512_set1_epi32(3);
+
+    for (uint64_t i = begin; i < end; i += 16) {
+        __mmask16 m = end - i >= 16 ? 0xffff : (1u << (end - i)) - 1;
+        __m512 x = _mm512_maskz_loadu_ps(m, a + i);
+
+        __m512 p0 = poly_avx512(x, x);
+        __m512 p1 = poly_avx512(
+            _mm512_mul_ps(x, _mm512_set1_ps(0.5f)),
+            _mm512_mul_ps(x, _mm512_set1_ps(1.5f)));
+
+        __m512i idx = _mm512_add_epi32(
+            _mm512_set1_epi32(static_cast<int32_t>(i)), lanes);
+        __mmask16 first = _mm512_cmplt_epi32_mask(
+            _mm512_and_epi32(idx, seven), three);
+
+        _mm512_mask_storeu_ps(r + i, m, _mm512_mask_blend_ps(first, p1, p0));
+    }
+}
+
+#else
+
+#define ma_avx2 ma_scalar
+#define ma_avx512 ma_scalar
+#define branch_avx2 branch_scalar
+#define branch_avx512 branch_scalar
+#define heavy_avx2 heavy_scalar
+#define heavy_avx512 heavy_scalar
+
+#endif // GCL_HOST_X86
+
+void host::ma(const float* a, const float* b, float* r, uint64_t begin,
+              uint64_t end) {
+    static const BinaryFn fn = select(ma_scalar, ma_avx2, ma_avx512);
+    fn(a, b, r, begin, end);
+}
+
+void host::branch(const float* a, const float* b, float* r, uint64_t begin,
+                  uint64_t end) {
+    static const BinaryFn fn = select(
+        branch_scalar, branch_avx2, branch_avx512);
+    fn(a, b, r, begin, end);
+}
+
+void host::heavy(const float* a, const float* b, float* r, uint64_t begin,
+                 uint64_t end) {
+    static const BinaryFn fn = select(
+        heavy_scalar, heavy_avx2, heavy_avx512);
+    fn(a, b, r, begin, end);
+}
+
+/// Adapts a kernel over (a, b, r) at bindings 0, 1 and 2 to a KernelFn.
+template<BinaryFn Fn>
+static void binary_kernel(void* const* bindings, uint64_t begin,
+                          uint64_t end) {
+    Fn(static_cast<const float*>(bindings[0]),
+       static_cast<const float*>(bindings[1]),
+       static_cast<float*>(bindings[2]),
+       begin,
+       end);
+}
+
+struct Registry {
+    std::mutex lock;
+    std::unordered_map<std::string, host::KernelImpl> kernels;
+};
+
+static Registry& get_registry() {
+    static Registry registry {
+        {},
+        {
+            { "ma", { binary_kernel<&host::ma>, 3, sizeof(float) } },
+            { "branch", { binary_kernel<&host::branch>, 3, sizeof(float) } },
+            { "heavy", { binary_kernel<&host::heavy>, 3, sizeof(float) } },
+        },
+    };
+
+    return registry;
+}
+
+void host::register_kernel(const std::string& name, KernelFn fn,
+                           uint32_t bindings, uint32_t stride) {
+    Registry& registry = get_registry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.kernels[name] = { fn, bindings, stride };
+}
+
+host::KernelImpl host::find_kernel(const std::string& name) {
+    Registry& registry = get_registry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    auto it = registry.kernels.find(name);
+    return it != registry.kernels.end() ? it->second : KernelImpl {};
+}
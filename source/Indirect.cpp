@@ -0,0 +1,37 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Indirect.h"
+
+#include <cstdint>
+
+using namespace gcl;
+
+/// Push constants of kernels/groups.comp.
+struct GroupsParams {
+    uint32_t local_size;
+    uint32_t count_index;
+    uint32_t args_index;
+};
+
+IndirectArgs::IndirectArgs(GCLContext& context)
+        : m_groups(context, embedded::groups) {}
+
+IndirectArgs::IndirectArgs(GCLContext& context, const std::string& compute)
+        : m_groups(context, compute) {}
+
+void IndirectArgs::compute(Kernel& kernel, Buffer<uint32_t>& counts, 
+                           uint32_t count_index, Buffer<uint32_t>& args, 
+                           uint32_t args_index) {
+    if (args.elements() < args_index + 3)
+        throw rt_error("indirect argument buffer is too small.");
+
+    m_groups.bind(0, counts);
+    m_groups.bind(1, args);
+    m_groups.push(GroupsParams { 
+        kernel.get_local_size_x(), count_index, args_index });
+
+    m_groups.dispatch(1);
+}
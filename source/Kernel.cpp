@@ -5,41 +5,118 @@
 
 #include "../include/Kernel.h"
 
+#include "../include/Trace.h"
 #include "../vendor/spirv_reflect.h"
 
 #include <algorithm>
 #include <cstdint>
+#include <filesystem>
 #include <fstream>
 #include <unordered_map>
 #include <vector>
 
 using namespace gcl;
 
-static std::vector<char> read_file(const std::string& path) {
+/// Read the SPIR-V binary at |path| into 32-bit words.
+static std::vector<uint32_t> read_spirv(const std::string& path) {
     // Open the file in binary mode and seek to the end to get the size.
     std::ifstream file(path, std::ios::ate | std::ios::binary);
     if (file.is_open() == false)
         throw rt_error("failed to open file: " + path);
 
     uint64_t size = file.tellg();
-    std::vector<char> buf(size);
+    if (size % sizeof(uint32_t) != 0)
+        throw rt_error("not a SPIR-V binary: " + path);
+
+    std::vector<uint32_t> buf(size / sizeof(uint32_t));
     file.seekg(0);
 
     // Read the file into the buffer.
-    if (!file.read(buf.data(), size))
+    if (!file.read(reinterpret_cast<char*>(buf.data()), size))
         throw rt_error("failed to read file: " + path);
 
     file.close();
     return buf;
 }
 
-Kernel::Kernel(GCLContext& context, const std::string& compute) 
+Kernel::Kernel(GCLContext& context, const std::string& compute,
+               bool host_impl) 
         : m_context(context) {
-    init_vulkan_compute_shader(compute);
+    std::string name = std::filesystem::path(compute).stem().string();
+
+    // Host contexts don't need the SPIR-V, but it is captured if it exists.
+    std::vector<uint32_t> spirv;
+    if (!m_context.is_host())
+        spirv = read_spirv(compute);
+    else if (capture::is_active() && std::filesystem::exists(compute))
+        spirv = read_spirv(compute);
+
+    capture::create_kernel(this, name, spirv.data(), spirv.size());
+
+    if (init_host(name, host_impl))
+        return;
+
+    init_vulkan(spirv);
+}
+
+Kernel::Kernel(GCLContext& context, const std::string& name, 
+               std::span<const uint32_t> spirv, bool host_impl) 
+        : m_context(context) {
+    capture::create_kernel(this, name, spirv.data(), spirv.size());
+
+    if (init_host(name, host_impl))
+        return;
+
+    init_vulkan(spirv);
+}
+
+Kernel::Kernel(GCLContext& context, const embedded::Spirv& spirv)
+        : Kernel(context, spirv.name, spirv.code, true) {}
+
+bool Kernel::init_host(const std::string& name, bool host_impl) {
+    // Only opted in kernels are matched by name, so that a user kernel that 
+    // shares a name with a shipped one isn't replaced by it.
+    if (host_impl)
+        m_host_impl = host::find_kernel(name);
+
+    if (!m_context.is_host())
+        return false;
+
+    if (m_host_impl.fn == nullptr)
+        throw rt_error("no host implementation for kernel: " + name);
+
+    return true;
+}
+
+bool Kernel::fits_host(uint64_t xelements) const {
+    if (m_host_impl.fn == nullptr
+          || m_host_bindings.size() < m_host_impl.bindings)
+        return false;
+
+    for (uint32_t idx = 0; idx < m_host_impl.bindings; ++idx) {
+        const HostBinding& binding = m_host_bindings[idx];
+        if (binding.alloc == nullptr && binding.host == nullptr)
+            return false;
+
+        if (m_host_impl.stride != 0 
+              && binding.size / m_host_impl.stride < xelements)
+            return false;
+    }
+
+    return true;
+}
+
+void Kernel::init_vulkan(std::span<const uint32_t> spirv) {
+    GCL_TIMED_SCOPE("Kernel::Kernel", PipelineCreateNs);
+    GCL_COUNT(PipelineCreations, 1);
+
+    init_vulkan_compute_shader(spirv);
     init_vulkan_compute_pipeline();
 }
 
 Kernel::~Kernel() {
+    capture::record(capture::Record::Type::DestroyKernel, this);
+
     if (m_desc_pool != nullptr) {
         vkDestroyDescriptorPool(m_context, m_desc_pool, nullptr);
         m_desc_pool = nullptr;
@@ -66,15 +143,13 @@ Kernel::~Kernel() {
     }
 }
 
-void Kernel::init_vulkan_compute_shader(const std::string& compute) {
-    std::vector<char> spv = read_file(compute);
-
-    reflect_descriptors(spv);
+void Kernel::init_vulkan_compute_shader(std::span<const uint32_t> spirv) {
+    reflect_descriptors(spirv);
 
     VkShaderModuleCreateInfo info {};
     info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    info.codeSize = spv.size();
-    info.pCode = reinterpret_cast<const uint32_t*>(spv.data());
+    info.codeSize = spirv.size_bytes();
+    info.pCode = spirv.data();
 
     VK_CHECK(vkCreateShaderModule(m_context, &info, nullptr, &m_compute));
 }
@@ -88,6 +163,16 @@ void Kernel::init_vulkan_compute_pipeline() {
         layout_info.pSetLayouts = &m_desc_layout;
     }
 
+    VkPushConstantRange push_range {};
+    push_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_range.offset = 0;
+    push_range.size = m_push_size;
+
+    if (m_push_size != 0) {
+        layout_info.pushConstantRangeCount = 1;
+        layout_info.pPushConstantRanges = &push_range;
+    }
+
     VK_CHECK(vkCreatePipelineLayout(
         m_context, &layout_info, nullptr, &m_layout));
 
@@ -106,15 +191,34 @@ void Kernel::init_vulkan_compute_pipeline() {
         m_context, nullptr, 1, &pipeline_info, nullptr, &m_pipeline));
 }
 
-void Kernel::reflect_descriptors(const std::vector<char>& spv) {
+void Kernel::reflect_descriptors(std::span<const uint32_t> spirv) {
     SpvReflectShaderModule module {};
-    SpvReflectResult res = spvReflectCreateShaderModule(spv.size(), spv.data(), &module);
+    SpvReflectResult res = spvReflectCreateShaderModule(
+        spirv.size_bytes(), spirv.data(), &module);
     if (res != SPV_REFLECT_RESULT_SUCCESS)
         throw rt_error("(SPIRV-Reflect) failed to make shader module for reflection.");
 
     m_local_size_x = std::max(
         static_cast<uint32_t>(1), module.entry_points[0].local_size.x);
 
+    uint32_t num_blocks = 0;
+    res = spvReflectEnumeratePushConstantBlocks(&module, &num_blocks, nullptr);
+    if (res != SPV_REFLECT_RESULT_SUCCESS) {
+        spvReflectDestroyShaderModule(&module);
+        throw rt_error("(SPIRV-Reflect) failed to list push constant blocks.");
+    }
+
+    std::vector<SpvReflectBlockVariable*> blocks(num_blocks);
+    res = spvReflectEnumeratePushConstantBlocks(
+        &module, &num_blocks, blocks.data());
+    if (res != SPV_REFLECT_RESULT_SUCCESS) {
+        spvReflectDestroyShaderModule(&module);
+        throw rt_error("(SPIRV-Reflect) failed to reflect push constants.");
+    }
+
+    for (const auto* block : blocks)
+        m_push_size = std::max(m_push_size, block->offset + block->size);
+
     uint32_t num_sets = 0;
     res = spvReflectEnumerateDescriptorSets(&module, &num_sets, nullptr);
     if (res != SPV_REFLECT_RESULT_SUCCESS) {
@@ -156,6 +260,7 @@ void Kernel::reflect_descriptors(const std::vector<char>& spv) {
             binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
             bindings.push_back(binding);
+            m_bindings.push_back(rb->binding);
 
             type_counts[binding.descriptorType] += binding.descriptorCount;
         }
@@ -202,6 +307,25 @@ void Kernel::dispatch(int32_t xelements, int32_t ygroups, int32_t zgroups) {
     if (xelements == 0 || ygroups == 0 || zgroups == 0)
         return;
 
+    GCL_SCOPE("Kernel::dispatch");
+    capture::dispatch(this, xelements, ygroups, zgroups);
+
+    // Dispatches that the host implementation can't run safely stay on the
+    // device, where they behave as they always did. Host contexts have no
+    // device, so dispatch_host reports them instead.
+    if (ygroups == 1 && zgroups == 1 
+          && (m_context.is_host() 
+            || (static_cast<uint64_t>(xelements) 
+                  < m_context.get_host_threshold()
+                && fits_host(xelements)))) {
+        dispatch_host(xelements);
+        return;
+    }
+
+    if (m_context.is_host())
+        throw rt_error("host kernels only support one dimensional dispatch.");
+
+    GCL_COUNT(Dispatches, 1);
     uint32_t groups_x = (xelements + m_local_size_x - 1u) / m_local_size_x;
 
     VkCommandBuffer cmd = m_context.get_command_buffer();
@@ -211,6 +335,113 @@ void Kernel::dispatch(int32_t xelements, int32_t ygroups, int32_t zgroups) {
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     VK_CHECK(vkBeginCommandBuffer(cmd, &begin_info));
 
+    record_bind(cmd, m_push);
+    vkCmdDispatch(cmd, groups_x, ygroups, zgroups);
+    VK_CHECK(vkEndCommandBuffer(cmd));
+
+    m_context.submit(cmd);
+}
+
+Completion Kernel::dispatch_async(int32_t xelements, int32_t ygroups, 
+                                  int32_t zgroups) {
+    if (xelements == 0 || ygroups == 0 || zgroups == 0)
+        return Completion();
+
+    GCL_SCOPE("Kernel::dispatch_async");
+    capture::dispatch(this, xelements, ygroups, zgroups);
+
+    if (ygroups == 1 && zgroups == 1 
+          && (m_context.is_host() 
+            || (static_cast<uint64_t>(xelements) 
+                  < m_context.get_host_threshold()
+                && fits_host(xelements)))) {
+        dispatch_host(xelements);
+        return Completion();
+    }
+
+    if (m_context.is_host())
+        throw rt_error("host kernels only support one dimensional dispatch.");
+
+    GCL_COUNT(Dispatches, 1);
+    uint32_t groups_x = (xelements + m_local_size_x - 1u) / m_local_size_x;
+
+    VkCommandPool pool = m_context.get_command_pool();
+    VkCommandBuffer cmd = m_context.acquire_command_buffer();
+
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK(vkBeginCommandBuffer(cmd, &begin_info));
+
+    // Other submissions may still be executing on the same queue, order this
+    // dispatch after their writes.
+    record_barrier(cmd);
+    record_bind(cmd, m_push);
+    vkCmdDispatch(cmd, groups_x, ygroups, zgroups);
+    VK_CHECK(vkEndCommandBuffer(cmd));
+
+    return m_context.submit_async(cmd, pool);
+}
+
+void Kernel::dispatch_indirect(Buffer<uint32_t>& args, uint64_t offset) {
+    if (m_context.is_host())
+        throw rt_error("indirect dispatch requires a device.");
+
+    check_indirect(args, offset);
+
+    GCL_SCOPE("Kernel::dispatch_indirect");
+    capture::dispatch_indirect(this, &args, offset);
+    GCL_COUNT(Dispatches, 1);
+
+    VkCommandBuffer cmd = m_context.get_command_buffer();
+    VK_CHECK(vkResetCommandBuffer(cmd, 0));
+
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    VK_CHECK(vkBeginCommandBuffer(cmd, &begin_info));
+
+    // The group counts were written by a shader in an earlier submission, 
+    // make them visible to the indirect command read.
+    record_barrier(cmd);
+    record_bind(cmd, m_push);
+    vkCmdDispatchIndirect(cmd, args, offset);
+    VK_CHECK(vkEndCommandBuffer(cmd));
+
+    m_context.submit(cmd);
+}
+
+void Kernel::check_indirect(const Buffer<uint32_t>& args, uint64_t offset) {
+    if (offset % sizeof(uint32_t) != 0)
+        throw rt_error("indirect argument offset must be a multiple of 4.");
+
+    if (offset > args.size() || args.size() - offset < 3 * sizeof(uint32_t))
+        throw rt_error("indirect argument buffer is too small.");
+}
+
+void Kernel::record_barrier(VkCommandBuffer cmd) {
+    VkMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT 
+        | VK_ACCESS_SHADER_READ_BIT 
+        | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT 
+            | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+}
+
+void Kernel::record_bind(VkCommandBuffer cmd, 
+                         const std::vector<uint8_t>& push) const {
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
     if (m_desc_set != nullptr) {
         vkCmdBindDescriptorSets(
@@ -224,17 +455,49 @@ void Kernel::dispatch(int32_t xelements, int32_t ygroups, int32_t zgroups) {
             nullptr);
     }
 
-    vkCmdDispatch(cmd, groups_x, ygroups, zgroups);
-    VK_CHECK(vkEndCommandBuffer(cmd));
+    if (!push.empty()) {
+        vkCmdPushConstants(
+            cmd, 
+            m_layout, 
+            VK_SHADER_STAGE_COMPUTE_BIT, 
+            0, 
+            static_cast<uint32_t>(push.size()), 
+            push.data());
+    }
+}
+
+void Kernel::dispatch_host(uint64_t xelements) {
+    if (m_host_impl.fn == nullptr)
+        throw rt_error("kernel has no host implementation.");
 
-    VkSubmitInfo submit {};
-    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit.commandBufferCount = 1;
-    submit.pCommandBuffers = &cmd;
+    if (!fits_host(xelements)) {
+        throw rt_error("the buffers bound to the kernel are missing or too "
+            "small for its host implementation.");
+    }
+
+    GCL_SCOPE("Kernel::dispatch_host");
+    GCL_COUNT(HostDispatches, 1);
+
+    // Device buffers are host-visible, so the host implementation can work
+    // on their mapped memory directly.
+    std::vector<void*> bindings(m_host_bindings.size(), nullptr);
+    for (uint32_t idx = 0; idx < m_host_bindings.size(); ++idx) {
+        const HostBinding& binding = m_host_bindings[idx];
+        if (binding.alloc != nullptr) {
+            VK_CHECK(vmaInvalidateAllocation(
+                m_context, binding.alloc, 0, VK_WHOLE_SIZE));
+            VK_CHECK(vmaMapMemory(m_context, binding.alloc, &bindings[idx]));
+        } else {
+            bindings[idx] = binding.host;
+        }
+    }
 
-    VkFence fence = m_context.get_fence();
+    host::run(m_host_impl.fn, bindings.data(), xelements);
 
-    VK_CHECK(vkResetFences(m_context, 1, &fence));
-    VK_CHECK(vkQueueSubmit(m_context.get_compute_queue(), 1, &submit, fence));
-    VK_CHECK(vkWaitForFences(m_context, 1, &fence, VK_TRUE, UINT64_MAX));
+    for (const HostBinding& binding : m_host_bindings) {
+        if (binding.alloc != nullptr) {
+            vmaFlushAllocation(m_context, binding.alloc, 0, VK_WHOLE_SIZE);
+            vmaUnmapMemory(m_context, binding.alloc);
+        }
+    }
 }
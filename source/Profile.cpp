@@ -0,0 +1,353 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Profile.h"
+#include "../include/Buffer.h"
+#include "../include/Embedded.h"
+#include "../include/GCLContext.h"
+#include "../include/Host.h"
+#include "../include/Kernel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+using namespace gcl;
+
+/// The version of the profile file format. Files of other versions are 
+/// ignored.
+static constexpr uint32_t PROFILE_VERSION = 2;
+
+/// The size of the buffers transferred and copied by the probe.
+static constexpr uint64_t PROBE_BYTES = 32 << 20;
+
+/// The number of times latencies are measured, of which the median is kept.
+static constexpr uint32_t LATENCY_SAMPLES = 101;
+
+/// The number of times bandwidths are measured, of which the best is kept.
+static constexpr uint32_t BANDWIDTH_SAMPLES = 3;
+
+/// The fewest and most workgroups tried when looking for the saturating
+/// group count. The most is the smallest maximum group count Vulkan allows.
+static constexpr uint32_t MIN_PROBE_GROUPS = 16;
+static constexpr uint32_t MAX_PROBE_GROUPS = 65535;
+
+/// The fraction of the best device bandwidth that counts as saturated.
+static constexpr double SATURATION = 0.9;
+
+/// The number of invocations of the ma kernel timed on the host.
+static constexpr uint64_t HOST_PROBE_ELEMENTS = 1 << 20;
+
+/// The bytes the ma kernel reads and writes per invocation.
+static constexpr double MA_BYTES = 3 * sizeof(float);
+
+/// The single-threaded work, in nanoseconds, that a host chunk should take
+/// to hide the cost of handing it to a worker.
+static constexpr double GRAIN_NS = 50'000.0;
+
+/// Bounds on the derived host parameters, so that a noisy measurement can't
+/// produce something absurd.
+static constexpr uint64_t MIN_GRAIN = 1 << 10;
+static constexpr uint64_t MAX_GRAIN = 1 << 20;
+static constexpr uint64_t MAX_HOST_THRESHOLD = 1 << 24;
+
+/// Push constants of kernels/probe_copy.comp.
+struct CopyParams {
+    uint32_t n;
+};
+
+/// Returns the number of microseconds that |fn| takes.
+static double time_us(const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/// Returns the median time of |samples| runs of |fn| in microseconds.
+static double median_us(uint32_t samples, const std::function<void()>& fn) {
+    std::vector<double> times(samples);
+    for (double& time : times)
+        time = time_us(fn);
+
+    std::nth_element(times.begin(), times.begin() + samples / 2, times.end());
+    return times[samples / 2];
+}
+
+/// Returns the best time of |samples| runs of |fn| in microseconds.
+static double best_us(uint32_t samples, const std::function<void()>& fn) {
+    double best = std::numeric_limits<double>::max();
+    for (uint32_t i = 0; i < samples; ++i)
+        best = std::min(best, time_us(fn));
+
+    return best;
+}
+
+/// Returns the bandwidth in GB/s of moving |bytes| in |us| microseconds, 
+/// of which |overhead_us| is fixed overhead.
+static double to_gbps(double bytes, double us, double overhead_us = 0.0) {
+    return bytes / (std::max(us - overhead_us, 1e-3) * 1e3);
+}
+
+/// Fill in the identity of the device of |context|.
+static void identify(const GCLContext& context, DeviceProfile& profile) {
+    VkPhysicalDeviceIDProperties id {};
+    id.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 props {};
+    props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    props.pNext = &id;
+
+    vkGetPhysicalDeviceProperties2(context.get_physical_device(), &props);
+
+    char hex[2 * VK_UUID_SIZE + 1];
+    for (uint32_t i = 0; i < VK_UUID_SIZE; ++i)
+        std::snprintf(hex + 2 * i, 3, "%02x", id.deviceUUID[i]);
+
+    profile.uuid = hex;
+    profile.device_name = props.properties.deviceName;
+    profile.driver_version = props.properties.driverVersion;
+}
+
+/// Submit an empty command buffer and wait for it.
+static void submit_empty(GCLContext& context) {
+    VkCommandBuffer cmd = context.get_command_buffer();
+    VK_CHECK(vkResetCommandBuffer(cmd, 0));
+
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    VK_CHECK(vkBeginCommandBuffer(cmd, &begin_info));
+    VK_CHECK(vkEndCommandBuffer(cmd));
+
+    context.submit(cmd);
+}
+
+/// Derive the dispatch parameters of |profile| from its measurements.
+static void derive(DeviceProfile& profile) {
+    uint32_t threads = host::get_num_threads();
+
+    // A dispatch of n invocations of ma costs about dispatch_us plus its
+    // memory traffic on the device, and n * host_ns / threads on the host.
+    double host_ns = profile.host_ns / threads;
+    double device_ns = MA_BYTES / profile.device_gbps;
+    double dispatch_ns = profile.dispatch_us * 1e3;
+
+    if (host_ns <= device_ns) {
+        profile.host_threshold = MAX_HOST_THRESHOLD;
+    } else {
+        profile.host_threshold = std::min<uint64_t>(
+            static_cast<uint64_t>(dispatch_ns / (host_ns - device_ns)),
+            MAX_HOST_THRESHOLD);
+    }
+
+    profile.host_grain = std::clamp<uint64_t>(
+        static_cast<uint64_t>(GRAIN_NS / std::max(profile.host_ns, 1e-3)),
+        MIN_GRAIN, MAX_GRAIN);
+}
+
+DeviceProfile gcl::probe(GCLContext& context) {
+    if (context.is_host())
+        throw rt_error("can't probe a host context.");
+
+    DeviceProfile profile;
+    identify(context, profile);
+
+    const uint64_t elements = PROBE_BYTES / sizeof(float);
+    Buffer<float> src(context, elements);
+    Buffer<float> dst(context, elements);
+    std::vector<float> data(elements, 1.f);
+
+    // Transfers. Warm up first, so that page faults aren't counted.
+    src.send(data);
+    dst.fetch();
+
+    profile.upload_gbps = to_gbps(PROBE_BYTES,
+        best_us(BANDWIDTH_SAMPLES, [&]() { src.send(data); }));
+    profile.download_gbps = to_gbps(PROBE_BYTES,
+        best_us(BANDWIDTH_SAMPLES, [&]() { dst.fetch(); }));
+
+    // Latencies.
+    Kernel copy(context, embedded::probe_copy);
+    copy.bind(0, src);
+    copy.bind(1, dst);
+
+    const uint32_t local_size = copy.get_local_size_x();
+    copy.push(CopyParams { 0 });
+    copy.dispatch(static_cast<int32_t>(local_size));
+
+    profile.submit_us = median_us(LATENCY_SAMPLES, [&]() {
+        submit_empty(context);
+    });
+    profile.dispatch_us = median_us(LATENCY_SAMPLES, [&]() {
+        copy.dispatch(static_cast<int32_t>(local_size));
+    });
+
+    // Device bandwidth for increasing group counts.
+    copy.push(CopyParams { static_cast<uint32_t>(elements / 4) });
+
+    std::vector<std::pair<uint32_t, double>> bandwidths;
+    for (uint32_t groups = MIN_PROBE_GROUPS;; groups *= 2) {
+        groups = std::min(groups, MAX_PROBE_GROUPS);
+        double us = best_us(BANDWIDTH_SAMPLES, [&]() {
+            copy.dispatch(static_cast<int32_t>(groups * local_size));
+        });
+
+        double gbps = to_gbps(2.0 * PROBE_BYTES, us, profile.dispatch_us);
+        bandwidths.emplace_back(groups, gbps);
+        profile.device_gbps = std::max(profile.device_gbps, gbps);
+
+        if (groups == MAX_PROBE_GROUPS)
+            break;
+    }
+
+    for (const auto& [groups, gbps] : bandwidths) {
+        if (gbps >= SATURATION * profile.device_gbps) {
+            profile.saturating_invocations =
+                static_cast<uint64_t>(groups) * local_size;
+            break;
+        }
+    }
+
+    // Single-threaded host throughput of the ma kernel.
+    std::vector<float> a(HOST_PROBE_ELEMENTS, 1.f);
+    std::vector<float> b(HOST_PROBE_ELEMENTS, 2.f);
+    std::vector<float> r(HOST_PROBE_ELEMENTS);
+
+    double host_us = best_us(BANDWIDTH_SAMPLES, [&]() {
+        host::ma(a.data(), b.data(), r.data(), 0, HOST_PROBE_ELEMENTS);
+    });
+    profile.host_ns = host_us * 1e3 / HOST_PROBE_ELEMENTS;
+
+    derive(profile);
+    return profile;
+}
+
+std::string gcl::get_profile_path(const std::string& uuid) {
+    std::filesystem::path dir;
+
+    const char* cache = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    if (cache != nullptr && *cache != '\0')
+        dir = cache;
+    else if (home != nullptr)
+        dir = std::filesystem::path(home) / ".cache";
+    else
+        dir = std::filesystem::temp_directory_path();
+
+    return (dir / "gcl" / (uuid + ".profile")).string();
+}
+
+std::optional<DeviceProfile> gcl::load_profile(const GCLContext& context) {
+    if (context.is_host())
+        return std::nullopt;
+
+    DeviceProfile current;
+    identify(context, current);
+
+    std::ifstream file(get_profile_path(current.uuid));
+    if (!file)
+        return std::nullopt;
+
+    // One "key value" pair per line.
+    std::unordered_map<std::string, std::string> entries;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t space = line.find(' ');
+        if (space != std::string::npos)
+            entries[line.substr(0, space)] = line.substr(space + 1);
+    }
+
+    DeviceProfile profile;
+    try {
+        if (std::stoul(entries.at("version")) != PROFILE_VERSION)
+            return std::nullopt;
+
+        profile.uuid = entries.at("uuid");
+        profile.device_name = entries.at("device_name");
+        profile.driver_version = std::stoul(entries.at("driver_version"));
+        profile.upload_gbps = std::stod(entries.at("upload_gbps"));
+        profile.download_gbps = std::stod(entries.at("download_gbps"));
+        profile.device_gbps = std::stod(entries.at("device_gbps"));
+        profile.dispatch_us = std::stod(entries.at("dispatch_us"));
+        profile.submit_us = std::stod(entries.at("submit_us"));
+        profile.host_ns = std::stod(entries.at("host_ns"));
+        profile.host_threshold = std::stoull(entries.at("host_threshold"));
+        profile.host_grain = std::stoull(entries.at("host_grain"));
+        profile.saturating_invocations =
+            std::stoull(entries.at("saturating_invocations"));
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+
+    if (profile.uuid != current.uuid 
+          || profile.driver_version != current.driver_version)
+        return std::nullopt;
+
+    return profile;
+}
+
+bool gcl::save_profile(const DeviceProfile& profile) {
+    if (!profile.is_measured())
+        return false;
+
+    std::filesystem::path path = get_profile_path(profile.uuid);
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error)
+        return false;
+
+    // Write to a temporary file first, so that concurrent readers never see
+    // a partial profile.
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+
+    std::ostringstream out;
+    out.precision(std::numeric_limits<double>::max_digits10);
+    out << "version " << PROFILE_VERSION << '\n'
+        << "uuid " << profile.uuid << '\n'
+        << "device_name " << profile.device_name << '\n'
+        << "driver_version " << profile.driver_version << '\n'
+        << "upload_gbps " << profile.upload_gbps << '\n'
+        << "download_gbps " << profile.download_gbps << '\n'
+        << "device_gbps " << profile.device_gbps << '\n'
+        << "dispatch_us " << profile.dispatch_us << '\n'
+        << "submit_us " << profile.submit_us << '\n'
+        << "host_ns " << profile.host_ns << '\n'
+        << "host_threshold " << profile.host_threshold << '\n'
+        << "host_grain " << profile.host_grain << '\n'
+        << "saturating_invocations " << profile.saturating_invocations
+        << '\n';
+
+    {
+        std::ofstream file(tmp, std::ios::trunc);
+        file << out.str();
+        if (!file.flush())
+            return false;
+    }
+
+    std::filesystem::rename(tmp, path, error);
+    return !error;
+}
+
+DeviceProfile gcl::load_or_probe(GCLContext& context) {
+    if (std::optional<DeviceProfile> cached = load_profile(context))
+        return *cached;
+
+    DeviceProfile profile = probe(context);
+    save_profile(profile);
+    return profile;
+}
@@ -0,0 +1,302 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Program.h"
+#include "../include/Capture.h"
+#include "../include/Trace.h"
+
+#include <cstdint>
+
+using namespace gcl;
+
+Program::Program(GCLContext& context) : m_context(context) {
+    if (m_context.is_host())
+        return;
+
+    VkCommandPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_info.queueFamilyIndex = m_context.get_compute_queue_family();
+
+    VK_CHECK(vkCreateCommandPool(m_context, &pool_info, nullptr, &m_pool));
+
+    VkCommandBufferAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = m_pool;
+    alloc_info.commandBufferCount = 1;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+    VkResult res = vkAllocateCommandBuffers(m_context, &alloc_info, &m_cmd);
+    if (res != VK_SUCCESS) {
+        vkDestroyCommandPool(m_context, m_pool, nullptr);
+        VK_CHECK(res);
+    }
+}
+
+Program::~Program() {
+    if (m_queries != nullptr) {
+        vkDestroyQueryPool(m_context, m_queries, nullptr);
+        m_queries = nullptr;
+    }
+
+    if (m_pool != nullptr) {
+        // Destroying the pool also frees the command buffer allocated from it.
+        vkDestroyCommandPool(m_context, m_pool, nullptr);
+        m_pool = nullptr;
+        m_cmd = nullptr;
+    }
+}
+
+void Program::check_bindings(const Kernel& kernel) const {
+    for (const Step& step : m_steps) {
+        if (step.kernel == &kernel && step.generation != kernel.m_generation) {
+            throw rt_error("kernel was rebound after it was added to the "
+                "program, and all of its steps would use the new bindings.");
+        }
+    }
+}
+
+uint32_t Program::add(Kernel& kernel, uint32_t xelements, uint32_t ygroups,
+                      uint32_t zgroups) {
+    check_bindings(kernel);
+
+    Step step {};
+    step.kernel = &kernel;
+    step.generation = kernel.m_generation;
+    // Rounded in 64 bits, as |xelements| near 2^32 would wrap.
+    step.groups_x = static_cast<uint32_t>(
+        (static_cast<uint64_t>(xelements) + kernel.m_local_size_x - 1) 
+            / kernel.m_local_size_x);
+    step.groups_y = ygroups;
+    step.groups_z = zgroups;
+    step.xelements = xelements;
+    step.push = kernel.m_push;
+
+    m_steps.push_back(std::move(step));
+    m_dirty = true;
+    return size() - 1;
+}
+
+uint32_t Program::add_indirect(Kernel& kernel, Buffer<uint32_t>& args, 
+                               uint64_t offset) {
+    if (m_context.is_host())
+        throw rt_error("indirect dispatch requires a device.");
+
+    Kernel::check_indirect(args, offset);
+    check_bindings(kernel);
+
+    Step step {};
+    step.kernel = &kernel;
+    step.generation = kernel.m_generation;
+    step.args = args;
+    step.offset = offset;
+    step.args_buffer = &args;
+    step.push = kernel.m_push;
+
+    m_steps.push_back(std::move(step));
+    m_dirty = true;
+    return size() - 1;
+}
+
+void Program::clear() {
+    m_steps.clear();
+    m_dirty = true;
+}
+
+void Program::reserve_queries(uint32_t count) {
+    if (count <= m_query_count)
+        return;
+
+    if (m_queries != nullptr) {
+        vkDestroyQueryPool(m_context, m_queries, nullptr);
+        m_queries = nullptr;
+        m_query_count = 0;
+    }
+
+    VkQueryPoolCreateInfo info {};
+    info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    info.queryCount = count;
+
+    VK_CHECK(vkCreateQueryPool(m_context, &info, nullptr, &m_queries));
+    m_query_count = count;
+}
+
+void Program::record() {
+    VK_CHECK(vkResetCommandBuffer(m_cmd, 0));
+
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    VK_CHECK(vkBeginCommandBuffer(m_cmd, &begin_info));
+
+    // Each step is timed from the end of the one before it, as the barriers
+    // keep steps from overlapping.
+    const uint32_t queries = size() + 1;
+    if (m_timed) {
+        reserve_queries(queries);
+        vkCmdResetQueryPool(m_cmd, m_queries, 0, queries);
+        vkCmdWriteTimestamp(
+            m_cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queries, 0);
+    }
+
+    for (uint32_t i = 0; i < size(); ++i) {
+        Step& step = m_steps[i];
+
+        // Every dispatch may consume the results of the one before it, or 
+        // of an earlier run of this program.
+        Kernel::record_barrier(m_cmd);
+        step.kernel->record_bind(m_cmd, step.push);
+
+        if (step.args != nullptr) {
+            vkCmdDispatchIndirect(m_cmd, step.args, step.offset);
+        } else if (step.groups_x != 0 && step.groups_y != 0 
+              && step.groups_z != 0) {
+            vkCmdDispatch(
+                m_cmd, step.groups_x, step.groups_y, step.groups_z);
+        }
+
+        if (m_timed) {
+            vkCmdWriteTimestamp(m_cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                m_queries, i + 1);
+        }
+
+        step.generation = step.kernel->m_generation;
+    }
+
+    VK_CHECK(vkEndCommandBuffer(m_cmd));
+    m_dirty = false;
+}
+
+void Program::capture_run() const {
+    if (!capture::is_active())
+        return;
+
+    capture::record(capture::Record::Type::BeginProgram, this);
+    for (const Step& step : m_steps) {
+        capture::push(step.kernel, step.push.data(), 
+            static_cast<uint32_t>(step.push.size()));
+
+        if (step.args != nullptr) {
+            capture::dispatch_indirect(
+                step.kernel, step.args_buffer, step.offset);
+        } else {
+            capture::dispatch(step.kernel, 
+                static_cast<uint32_t>(step.xelements), 
+                step.groups_y, step.groups_z);
+        }
+    }
+
+    capture::record(capture::Record::Type::EndProgram, this);
+}
+
+void Program::run() {
+    if (m_steps.empty())
+        return;
+
+    GCL_SCOPE("Program::run");
+    capture_run();
+
+    if (m_context.is_host()) {
+        for (const Step& step : m_steps)
+            step.kernel->dispatch_host(step.xelements);
+
+        return;
+    }
+
+    for (const Step& step : m_steps) {
+        if (step.generation != step.kernel->m_generation)
+            m_dirty = true;
+    }
+
+    if (m_dirty)
+        record();
+
+    GCL_COUNT(Dispatches, m_steps.size());
+    m_timed_steps = 0;
+    m_context.submit(m_cmd);
+    m_timed_steps = m_timed ? size() : 0;
+}
+
+Completion Program::run_async() {
+    if (m_steps.empty())
+        return Completion();
+
+    GCL_SCOPE("Program::run_async");
+    capture_run();
+
+    if (m_context.is_host()) {
+        for (const Step& step : m_steps)
+            step.kernel->dispatch_host(step.xelements);
+
+        return Completion();
+    }
+
+    for (const Step& step : m_steps) {
+        if (step.generation != step.kernel->m_generation)
+            m_dirty = true;
+    }
+
+    if (m_dirty)
+        record();
+
+    GCL_COUNT(Dispatches, m_steps.size());
+    m_timed_steps = 0;
+    Completion completion = m_context.submit_async(m_cmd);
+    m_timed_steps = m_timed ? size() : 0;
+    return completion;
+}
+
+void Program::set_timed(bool timed) {
+    if (timed == m_timed)
+        return;
+
+    if (timed && !m_context.is_host()) {
+        uint32_t num_families = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(
+            m_context.get_physical_device(), &num_families, nullptr);
+
+        std::vector<VkQueueFamilyProperties> families(num_families);
+        vkGetPhysicalDeviceQueueFamilyProperties(
+            m_context.get_physical_device(), &num_families, families.data());
+
+        const VkQueueFamilyProperties& family =
+            families.at(m_context.get_compute_queue_family());
+        const uint32_t bits = family.timestampValidBits;
+        if (bits == 0)
+            throw rt_error("the compute queue has no timestamps.");
+
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(m_context.get_physical_device(), &props);
+
+        m_timestamp_ns = props.limits.timestampPeriod;
+        m_timestamp_mask = bits >= 64
+            ? ~uint64_t(0)
+            : (uint64_t(1) << bits) - 1;
+    }
+
+    m_timed = timed;
+    m_timed_steps = 0;
+    m_dirty = true;
+}
+
+std::vector<double> Program::get_step_us() const {
+    if (m_timed_steps == 0)
+        return {};
+
+    std::vector<uint64_t> ticks(m_timed_steps + 1);
+    VK_CHECK(vkGetQueryPoolResults(m_context, m_queries, 0,
+        static_cast<uint32_t>(ticks.size()), ticks.size() * sizeof(uint64_t),
+        ticks.data(), sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+    std::vector<double> us(m_timed_steps);
+    for (uint32_t i = 0; i < m_timed_steps; ++i) {
+        // Differences of masked timestamps stay right across a wrap.
+        uint64_t elapsed = (ticks[i + 1] - ticks[i]) & m_timestamp_mask;
+        us[i] = static_cast<double>(elapsed) * m_timestamp_ns / 1e3;
+    }
+
+    return us;
+}
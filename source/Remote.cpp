@@ -0,0 +1,236 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Remote.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace gcl;
+
+using rt_error = std::runtime_error;
+
+/// Returns |what| followed by the description of errno.
+static rt_error sys_error(const std::string& what) {
+    return rt_error(what + ": " + std::strerror(errno));
+}
+
+std::string remote::default_socket_path() {
+    const char* socket = std::getenv("GCL_SOCKET");
+    if (socket != nullptr && *socket != '\0')
+        return socket;
+
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime != nullptr && *runtime != '\0')
+        return std::string(runtime) + "/gcld.sock";
+
+    return "/tmp/gcld-" + std::to_string(getuid()) + ".sock";
+}
+
+RemoteContext::RemoteContext(const std::string& path) {
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        throw rt_error("socket path too long: " + path);
+
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    m_socket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (m_socket < 0)
+        throw sys_error("failed to create socket");
+
+    if (connect(m_socket, reinterpret_cast<sockaddr*>(&addr), 
+          sizeof(addr)) != 0) {
+        rt_error error = sys_error("failed to connect to " + path);
+        close(m_socket);
+        throw error;
+    }
+
+    remote::Request hello;
+    hello.op = remote::Op::Hello;
+    hello.size = remote::PROTOCOL_VERSION;
+
+    try {
+        m_alignment = std::max<uint64_t>(request(hello).value, 1);
+    } catch (...) {
+        close(m_socket);
+        throw;
+    }
+}
+
+RemoteContext::~RemoteContext() {
+    close(m_socket);
+}
+
+remote::Reply RemoteContext::request(const remote::Request& request, int fd) {
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    iovec iov {};
+    iov.iov_base = const_cast<remote::Request*>(&request);
+    iov.iov_len = sizeof(request);
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+    msghdr msg {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (fd >= 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(m_socket, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+
+    if (sent != static_cast<ssize_t>(sizeof(request)))
+        throw sys_error("failed to send request to gcld");
+
+    remote::Reply reply;
+    ssize_t received;
+    do {
+        received = recv(m_socket, &reply, sizeof(reply), 0);
+    } while (received < 0 && errno == EINTR);
+
+    if (received != static_cast<ssize_t>(sizeof(reply)))
+        throw rt_error("lost connection to gcld.");
+
+    if (reply.status != 0) {
+        reply.error[remote::MAX_ERROR - 1] = '\0';
+        throw rt_error(std::string("(gcld) ") + reply.error);
+    }
+
+    return reply;
+}
+
+SharedMemory::SharedMemory(uint64_t size) : m_size(size) {
+    m_fd = memfd_create("gcl", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (m_fd < 0)
+        throw sys_error("failed to create shared memory");
+
+    if (ftruncate(m_fd, static_cast<off_t>(m_size)) != 0) {
+        rt_error error = sys_error("failed to size shared memory");
+        close(m_fd);
+        throw error;
+    }
+
+    // The daemon maps the memory, and refuses it unless it can't shrink
+    // under that mapping.
+    if (fcntl(m_fd, F_ADD_SEALS, F_SEAL_SHRINK) != 0) {
+        rt_error error = sys_error("failed to seal shared memory");
+        close(m_fd);
+        throw error;
+    }
+
+    m_data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, 
+        m_fd, 0);
+    if (m_data == MAP_FAILED) {
+        rt_error error = sys_error("failed to map shared memory");
+        close(m_fd);
+        throw error;
+    }
+}
+
+SharedMemory::~SharedMemory() {
+    munmap(m_data, m_size);
+    close(m_fd);
+}
+
+uint64_t gcl::shared_size(const RemoteContext& context, uint64_t bytes) {
+    uint64_t alignment = context.get_alignment();
+    return (std::max<uint64_t>(bytes, 1) + alignment - 1) 
+        / alignment * alignment;
+}
+
+uint32_t gcl::create_remote_buffer(RemoteContext& context,
+                                   const SharedMemory& memory,
+                                   uint64_t bytes) {
+    remote::Request request;
+    request.op = remote::Op::CreateBuffer;
+    request.size = bytes;
+
+    return context.request(request, memory.fd()).id;
+}
+
+void gcl::destroy_remote(RemoteContext& context, remote::Op op, 
+                         uint32_t id) {
+    remote::Request request;
+    request.op = op;
+    request.id = id;
+
+    try {
+        context.request(request);
+    } catch (const rt_error&) {
+        // The daemon frees everything of a client when it disconnects.
+    }
+}
+
+RemoteKernel::RemoteKernel(RemoteContext& context, const std::string& name,
+                           std::span<const uint32_t> spirv)
+        : m_context(context) {
+    if (name.size() >= remote::MAX_NAME)
+        throw rt_error("kernel name too long: " + name);
+
+    // The SPIR-V may be larger than a message, so it is shared instead.
+    uint64_t bytes = spirv.size_bytes();
+    SharedMemory code(shared_size(context, bytes));
+    std::memcpy(code.data(), spirv.data(), bytes);
+
+    remote::Request request;
+    request.op = remote::Op::CreateKernel;
+    request.size = bytes;
+    std::memcpy(request.name, name.c_str(), name.size() + 1);
+
+    remote::Reply reply = m_context.request(request, code.fd());
+    m_id = reply.id;
+    m_local_size_x = static_cast<uint32_t>(reply.value);
+
+    m_dispatch.op = remote::Op::Dispatch;
+    m_dispatch.id = m_id;
+}
+
+RemoteKernel::RemoteKernel(RemoteContext& context, 
+                           const embedded::Spirv& spirv)
+        : RemoteKernel(context, spirv.name, spirv.code) {}
+
+RemoteKernel::~RemoteKernel() {
+    destroy_remote(m_context, remote::Op::DestroyKernel, m_id);
+}
+
+void RemoteKernel::push_bytes(const void* data, uint32_t size) {
+    if (size > remote::MAX_PUSH)
+        throw rt_error("push constants exceed the remote maximum.");
+
+    m_dispatch.push_size = size;
+    std::memcpy(m_dispatch.push, data, size);
+}
+
+void RemoteKernel::dispatch(int32_t xelements, int32_t ygroups,
+                            int32_t zgroups) {
+    if (xelements <= 0 || ygroups <= 0 || zgroups <= 0)
+        return;
+
+    m_dispatch.x = static_cast<uint32_t>(xelements);
+    m_dispatch.y = static_cast<uint32_t>(ygroups);
+    m_dispatch.z = static_cast<uint32_t>(zgroups);
+    m_context.request(m_dispatch);
+}
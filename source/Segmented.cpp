@@ -0,0 +1,202 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Segmented.h"
+#include "../include/Embedded.h"
+#include "../include/Host.h"
+#include "../include/Trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+using namespace gcl;
+
+/// The most workgroups dispatched, unless the device profile says fewer
+/// saturate the device. The kernels loop over the remaining segments.
+static constexpr uint32_t MAX_GROUPS = 65535;
+
+/// Push constants of kernels/seg_reduce.comp.
+struct ReduceParams {
+    uint32_t segments;
+    uint32_t op;
+};
+
+/// Push constants of kernels/seg_ma.comp.
+struct MaParams {
+    uint32_t segments;
+};
+
+/// Returns the offsets table of segments with the given |sizes|.
+static std::vector<uint32_t> make_offsets(const std::vector<uint32_t>& sizes) {
+    std::vector<uint32_t> offsets;
+    offsets.reserve(sizes.size() + 1);
+    offsets.push_back(0);
+
+    uint64_t total = 0;
+    for (uint32_t size : sizes) {
+        total += size;
+        if (total > std::numeric_limits<uint32_t>::max())
+            throw rt_error("too many elements for a single batch.");
+
+        offsets.push_back(static_cast<uint32_t>(total));
+    }
+
+    return offsets;
+}
+
+/// Returns the number of elements to allocate for |n| elements, as buffers
+/// can't be empty.
+static uint64_t at_least_one(uint64_t n) {
+    return std::max<uint64_t>(n, 1);
+}
+
+SegmentedBatch::SegmentedBatch(GCLContext& context,
+                               const std::vector<uint32_t>& sizes)
+        : m_context(context), m_offsets(make_offsets(sizes)),
+          m_data(context, at_least_one(m_offsets.back())),
+          m_offset_buf(context, m_offsets.size()) {
+    m_offset_buf.send(m_offsets);
+}
+
+void SegmentedBatch::send(const std::vector<std::vector<float>>& segments) {
+    if (segments.size() != get_segments())
+        throw rt_error("segment count doesn't match the batch.");
+
+    std::vector<float> packed;
+    packed.reserve(get_elements());
+    for (uint32_t seg = 0; seg < segments.size(); ++seg) {
+        if (segments[seg].size() != m_offsets[seg + 1] - m_offsets[seg])
+            throw rt_error("segment size doesn't match the batch.");
+
+        packed.insert(packed.end(), segments[seg].begin(),
+            segments[seg].end());
+    }
+
+    m_data.send(packed);
+}
+
+std::vector<std::vector<float>> SegmentedBatch::fetch() const {
+    std::vector<float> packed = m_data.fetch();
+
+    std::vector<std::vector<float>> segments(get_segments());
+    for (uint32_t seg = 0; seg < segments.size(); ++seg) {
+        segments[seg].assign(packed.begin() + m_offsets[seg],
+            packed.begin() + m_offsets[seg + 1]);
+    }
+
+    return segments;
+}
+
+/// Returns the reduction of an empty segment under |op|.
+static float identity(SegmentOp op) {
+    switch (op) {
+    case SegmentOp::Sum:
+        return 0.f;
+    case SegmentOp::Min:
+        return std::numeric_limits<float>::infinity();
+    case SegmentOp::Max:
+        return -std::numeric_limits<float>::infinity();
+    }
+
+    throw rt_error("unknown segment op.");
+}
+
+SegmentedOps::SegmentedOps(GCLContext& context) : m_context(context) {
+    if (m_context.is_host())
+        return;
+
+    m_reduce = std::make_unique<Kernel>(m_context, embedded::seg_reduce);
+    m_ma = std::make_unique<Kernel>(m_context, embedded::seg_ma);
+}
+
+std::vector<float> SegmentedOps::reduce(SegmentedBatch& batch, SegmentOp op) {
+    GCL_SCOPE("SegmentedOps::reduce");
+
+    const uint32_t segments = batch.get_segments();
+    const float init = identity(op);
+
+    if (m_context.is_host()) {
+        const float* data = static_cast<const float*>(
+            batch.data().host_data());
+        const std::vector<uint32_t>& offsets = batch.get_offsets();
+
+        std::vector<float> results(segments);
+        host::parallel_for(segments, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t seg = begin; seg < end; ++seg) {
+                float acc = init;
+                for (uint32_t i = offsets[seg]; i < offsets[seg + 1]; ++i) {
+                    if (op == SegmentOp::Sum)
+                        acc += data[i];
+                    else if (op == SegmentOp::Min)
+                        acc = std::min(acc, data[i]);
+                    else
+                        acc = std::max(acc, data[i]);
+                }
+
+                results[seg] = acc;
+            }
+        });
+
+        return results;
+    }
+
+    if (segments == 0)
+        return {};
+
+    if (m_results == nullptr || m_results->elements() < segments)
+        m_results = std::make_unique<Buffer<float>>(m_context, segments);
+
+    m_reduce->bind(0, batch.data());
+    m_reduce->bind(1, batch.offsets());
+    m_reduce->bind(2, *m_results);
+    m_reduce->push(ReduceParams { segments, static_cast<uint32_t>(op) });
+
+    uint32_t local_size = m_reduce->get_local_size_x();
+    uint32_t groups = std::min(segments,
+        m_context.get_max_groups(MAX_GROUPS, local_size));
+    m_reduce->dispatch(static_cast<int32_t>(groups * local_size));
+
+    std::vector<float> results = m_results->fetch();
+    results.resize(segments);
+    return results;
+}
+
+void SegmentedOps::ma(SegmentedBatch& a, SegmentedBatch& b,
+                      SegmentedBatch& res) {
+    if (!a.same_layout(b) || !a.same_layout(res))
+        throw rt_error("segmented batches differ in layout.");
+
+    GCL_SCOPE("SegmentedOps::ma");
+
+    const uint32_t segments = a.get_segments();
+
+    if (m_context.is_host()) {
+        const float* pa = static_cast<const float*>(a.data().host_data());
+        const float* pb = static_cast<const float*>(b.data().host_data());
+        float* pr = static_cast<float*>(res.data().host_data());
+
+        host::parallel_for(a.get_elements(), [&](uint64_t begin, uint64_t end) {
+            for (uint64_t i = begin; i < end; ++i)
+                pr[i] = pa[i] * pb[i] + 1.f;
+        });
+
+        return;
+    }
+
+    if (segments == 0)
+        return;
+
+    m_ma->bind(0, a.data());
+    m_ma->bind(1, b.data());
+    m_ma->bind(2, res.data());
+    m_ma->bind(3, a.offsets());
+    m_ma->push(MaParams { segments });
+
+    uint32_t local_size = m_ma->get_local_size_x();
+    uint32_t groups = std::min(segments,
+        m_context.get_max_groups(MAX_GROUPS, local_size));
+    m_ma->dispatch(static_cast<int32_t>(groups * local_size));
+}
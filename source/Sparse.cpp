@@ -0,0 +1,353 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Sparse.h"
+#include "../include/Embedded.h"
+#include "../include/Host.h"
+#include "../include/Trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+using namespace gcl;
+
+/// Rows up to this long get one invocation each.
+static constexpr uint32_t SCALAR_MAX_ROW = 16;
+
+/// Rows up to this long get one subgroup each, longer rows a workgroup.
+static constexpr uint32_t VECTOR_MAX_ROW = 2048;
+
+/// Rows up to this long get one invocation each when the device has no
+/// subgroup arithmetic, so that the vector bin can't be used.
+static constexpr uint32_t SCALAR_MAX_ROW_NO_SUBGROUPS = 64;
+
+/// The most workgroups dispatched per bin, unless the device profile says
+/// fewer saturate the device. The kernels loop over the rest.
+static constexpr uint32_t MAX_GROUPS = 65535;
+
+/// Push constants of the CSR kernels.
+struct CsrParams {
+    uint32_t offset;
+    uint32_t count;
+};
+
+/// Push constants of kernels/spmv_ell.comp.
+struct EllParams {
+    uint32_t rows;
+    uint32_t width;
+};
+
+CsrMatrix CsrMatrix::from_coo(uint32_t rows, uint32_t cols,
+                              const std::vector<uint32_t>& r,
+                              const std::vector<uint32_t>& c,
+                              const std::vector<float>& v) {
+    if (r.size() != c.size() || r.size() != v.size())
+        throw rt_error("coordinate arrays differ in length.");
+
+    // Bucket the entries by row.
+    std::vector<uint64_t> starts(rows + 1, 0);
+    for (uint64_t i = 0; i < r.size(); ++i) {
+        if (r[i] >= rows || c[i] >= cols)
+            throw rt_error("coordinate out of range.");
+
+        ++starts[r[i] + 1];
+    }
+
+    for (uint32_t row = 0; row < rows; ++row)
+        starts[row + 1] += starts[row];
+
+    std::vector<std::pair<uint32_t, float>> entries(r.size());
+    std::vector<uint64_t> next(starts.begin(), starts.end() - 1);
+    for (uint64_t i = 0; i < r.size(); ++i)
+        entries[next[r[i]]++] = { c[i], v[i] };
+
+    CsrMatrix csr;
+    csr.rows = rows;
+    csr.cols = cols;
+    csr.row_ptr.reserve(rows + 1);
+    csr.col_idx.reserve(r.size());
+    csr.values.reserve(r.size());
+    csr.row_ptr.push_back(0);
+
+    // Sort every row by column and merge duplicates.
+    for (uint32_t row = 0; row < rows; ++row) {
+        auto begin = entries.begin() + starts[row];
+        auto end = entries.begin() + starts[row + 1];
+        std::sort(begin, end, [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+
+        for (auto it = begin; it != end; ++it) {
+            bool row_has_entries = csr.col_idx.size() > csr.row_ptr.back();
+            if (row_has_entries && csr.col_idx.back() == it->first) {
+                csr.values.back() += it->second;
+                continue;
+            }
+
+            csr.col_idx.push_back(it->first);
+            csr.values.push_back(it->second);
+        }
+
+        csr.row_ptr.push_back(static_cast<uint32_t>(csr.col_idx.size()));
+    }
+
+    return csr;
+}
+
+EllMatrix EllMatrix::from_csr(const CsrMatrix& csr) {
+    EllMatrix ell;
+    ell.rows = csr.rows;
+    ell.cols = csr.cols;
+
+    for (uint32_t row = 0; row < csr.rows; ++row) {
+        ell.width = std::max(ell.width,
+            csr.row_ptr[row + 1] - csr.row_ptr[row]);
+    }
+
+    uint64_t size = static_cast<uint64_t>(ell.width) * ell.rows;
+    ell.col_idx.assign(size, PADDING);
+    ell.values.assign(size, 0.f);
+
+    for (uint32_t row = 0; row < csr.rows; ++row) {
+        for (uint32_t k = csr.row_ptr[row]; k < csr.row_ptr[row + 1]; ++k) {
+            uint64_t idx =
+                static_cast<uint64_t>(k - csr.row_ptr[row]) * ell.rows + row;
+            ell.col_idx[idx] = csr.col_idx[k];
+            ell.values[idx] = csr.values[k];
+        }
+    }
+
+    return ell;
+}
+
+/// y = A * x over the rows of a CSR matrix, in parallel.
+static void multiply_csr(uint32_t rows, const uint32_t* row_ptr, 
+                         const uint32_t* col_idx, const float* values,
+                         const float* x, float* y) {
+    host::parallel_for(rows, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t row = begin; row < end; ++row) {
+            float sum = 0.f;
+            for (uint32_t k = row_ptr[row]; k < row_ptr[row + 1]; ++k)
+                sum += values[k] * x[col_idx[k]];
+
+            y[row] = sum;
+        }
+    });
+}
+
+/// y = A * x over the rows of an ELL matrix, in parallel.
+static void multiply_ell(uint32_t rows, uint32_t width, 
+                         const uint32_t* col_idx, const float* values,
+                         const float* x, float* y) {
+    host::parallel_for(rows, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t row = begin; row < end; ++row) {
+            float sum = 0.f;
+            for (uint32_t k = 0; k < width; ++k) {
+                uint64_t idx = static_cast<uint64_t>(k) * rows + row;
+                if (col_idx[idx] != EllMatrix::PADDING)
+                    sum += values[idx] * x[col_idx[idx]];
+            }
+
+            y[row] = sum;
+        }
+    });
+}
+
+void gcl::spmv(const CsrMatrix& a, const float* x, float* y) {
+    multiply_csr(a.rows, a.row_ptr.data(), a.col_idx.data(), a.values.data(),
+        x, y);
+}
+
+void gcl::spmv(const EllMatrix& a, const float* x, float* y) {
+    multiply_ell(a.rows, a.width, a.col_idx.data(), a.values.data(), x, y);
+}
+
+/// Returns the number of elements to allocate for |n| elements, as buffers
+/// can't be empty.
+static uint64_t at_least_one(uint64_t n) {
+    return std::max<uint64_t>(n, 1);
+}
+
+/// Throws unless |a| is well formed, as the kernels trust its row pointers
+/// and column indices.
+static void validate(const CsrMatrix& a) {
+    if (a.row_ptr.size() != static_cast<uint64_t>(a.rows) + 1)
+        throw rt_error("CSR row pointers must number rows + 1.");
+
+    if (a.col_idx.size() != a.values.size())
+        throw rt_error("CSR column indices and values differ in count.");
+
+    if (a.row_ptr.front() != 0 || a.row_ptr.back() != a.nnz())
+        throw rt_error("CSR row pointers must span all stored entries.");
+
+    for (uint32_t row = 0; row < a.rows; ++row) {
+        if (a.row_ptr[row] > a.row_ptr[row + 1])
+            throw rt_error("CSR row pointers must be non-decreasing.");
+    }
+
+    for (uint32_t col : a.col_idx) {
+        if (col >= a.cols)
+            throw rt_error("CSR column index out of range.");
+    }
+}
+
+CsrSpmv::CsrSpmv(GCLContext& context, const CsrMatrix& a)
+        : m_context(context), m_rows(a.rows), m_cols(a.cols),
+          m_row_ptr(context, at_least_one(a.row_ptr.size())),
+          m_col_idx(context, at_least_one(a.nnz())),
+          m_values(context, at_least_one(a.nnz())),
+          m_binned(context, at_least_one(a.rows)),
+          m_program(context) {
+    validate(a);
+
+    m_row_ptr.send(a.row_ptr);
+    m_col_idx.send(a.col_idx);
+    m_values.send(a.values);
+
+    if (m_context.is_host())
+        return;
+
+    const DeviceFeatures& features = m_context.get_features();
+    uint32_t scalar_max = features.subgroup_arithmetic
+        ? SCALAR_MAX_ROW
+        : SCALAR_MAX_ROW_NO_SUBGROUPS;
+
+    std::vector<uint32_t> bins[NUM_ROW_BINS];
+    for (uint32_t row = 0; row < a.rows; ++row) {
+        uint32_t length = a.row_ptr[row + 1] - a.row_ptr[row];
+
+        RowBin bin = RowBin::Block;
+        if (length <= scalar_max)
+            bin = RowBin::Scalar;
+        else if (length <= VECTOR_MAX_ROW && features.subgroup_arithmetic)
+            bin = RowBin::Vector;
+
+        bins[static_cast<uint32_t>(bin)].push_back(row);
+    }
+
+    std::vector<uint32_t> binned;
+    binned.reserve(a.rows);
+    for (const auto& bin : bins)
+        binned.insert(binned.end(), bin.begin(), bin.end());
+
+    m_binned.send(binned);
+
+    const embedded::Spirv* spirv[NUM_ROW_BINS] = {
+        &embedded::spmv_csr_scalar,
+        &embedded::spmv_csr_vector,
+        &embedded::spmv_csr_block,
+    };
+
+    uint32_t offset = 0;
+    for (uint32_t idx = 0; idx < NUM_ROW_BINS; ++idx) {
+        uint32_t count = static_cast<uint32_t>(bins[idx].size());
+        m_bin_rows[idx] = count;
+        if (count == 0)
+            continue;
+
+        auto kernel = std::make_unique<Kernel>(m_context, *spirv[idx]);
+        kernel->bind(0, m_row_ptr);
+        kernel->bind(1, m_col_idx);
+        kernel->bind(2, m_values);
+        kernel->bind(5, m_binned);
+        kernel->push(CsrParams { offset, count });
+
+        uint32_t local_size = kernel->get_local_size_x();
+
+        // The number of rows a workgroup handles at once.
+        uint32_t rows_per_group = local_size;
+        if (idx == static_cast<uint32_t>(RowBin::Vector))
+            rows_per_group = std::max(1u, local_size / features.subgroup_size);
+        else if (idx == static_cast<uint32_t>(RowBin::Block))
+            rows_per_group = 1;
+
+        uint32_t groups = std::min(
+            (count + rows_per_group - 1) / rows_per_group, 
+            m_context.get_max_groups(MAX_GROUPS, local_size));
+        m_program.add(*kernel, groups * local_size);
+
+        m_kernels[idx] = std::move(kernel);
+        offset += count;
+    }
+}
+
+void CsrSpmv::multiply(Buffer<float>& x, Buffer<float>& y) {
+    if (x.elements() < m_cols || y.elements() < m_rows)
+        throw rt_error("vector too small for the matrix.");
+
+    GCL_SCOPE("CsrSpmv::multiply");
+
+    if (m_context.is_host()) {
+        multiply_csr(m_rows,
+            static_cast<const uint32_t*>(m_row_ptr.host_data()),
+            static_cast<const uint32_t*>(m_col_idx.host_data()),
+            static_cast<const float*>(m_values.host_data()),
+            static_cast<const float*>(x.host_data()),
+            static_cast<float*>(y.host_data()));
+        return;
+    }
+
+    // Rebinding invalidates the program, so iterative solvers that multiply
+    // the same vectors reuse the recorded one.
+    if (x.id() != m_bound_x || y.id() != m_bound_y) {
+        for (auto& kernel : m_kernels) {
+            if (kernel == nullptr)
+                continue;
+
+            kernel->bind(3, x);
+            kernel->bind(4, y);
+        }
+
+        m_bound_x = x.id();
+        m_bound_y = y.id();
+    }
+
+    m_program.run();
+}
+
+EllSpmv::EllSpmv(GCLContext& context, const EllMatrix& a)
+        : m_context(context), m_rows(a.rows), m_cols(a.cols),
+          m_width(a.width),
+          m_col_idx(context, at_least_one(a.col_idx.size())),
+          m_values(context, at_least_one(a.values.size())) {
+    m_col_idx.send(a.col_idx);
+    m_values.send(a.values);
+
+    if (m_context.is_host())
+        return;
+
+    m_kernel = std::make_unique<Kernel>(m_context, embedded::spmv_ell);
+    m_kernel->bind(0, m_col_idx);
+    m_kernel->bind(1, m_values);
+    m_kernel->push(EllParams { m_rows, m_width });
+}
+
+void EllSpmv::multiply(Buffer<float>& x, Buffer<float>& y) {
+    if (x.elements() < m_cols || y.elements() < m_rows)
+        throw rt_error("vector too small for the matrix.");
+
+    GCL_SCOPE("EllSpmv::multiply");
+
+    if (m_context.is_host()) {
+        multiply_ell(m_rows, m_width,
+            static_cast<const uint32_t*>(m_col_idx.host_data()),
+            static_cast<const float*>(m_values.host_data()),
+            static_cast<const float*>(x.host_data()),
+            static_cast<float*>(y.host_data()));
+        return;
+    }
+
+    if (m_rows == 0)
+        return;
+
+    m_kernel->bind(2, x);
+    m_kernel->bind(3, y);
+
+    uint32_t local_size = m_kernel->get_local_size_x();
+    uint32_t groups = std::min((m_rows + local_size - 1) / local_size, 
+        m_context.get_max_groups(MAX_GROUPS, local_size));
+    m_kernel->dispatch(static_cast<int32_t>(groups * local_size));
+}
@@ -0,0 +1,255 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Trace.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace gcl;
+
+/// The maximum number of events kept per thread, past which they are dropped.
+static constexpr uint64_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+std::atomic<uint32_t> trace::detail::g_flags = 0;
+
+namespace {
+
+struct Event {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+/// The instrumentation state of a single thread. Counters are only written
+/// by their own thread, so they use relaxed loads and stores rather than
+/// read-modify-write operations.
+struct ThreadData {
+    uint32_t tid = 0;
+    std::atomic<uint64_t> counters[trace::NUM_COUNTERS] = {};
+
+    std::mutex events_lock;
+    std::vector<Event> events;
+    uint64_t dropped = 0;
+};
+
+/// Every thread that has recorded anything. Shared ownership keeps the data
+/// of exited threads around until it has been exported.
+struct Registry {
+    std::mutex lock;
+    std::vector<std::shared_ptr<ThreadData>> threads;
+    std::string path;
+};
+
+} // namespace
+
+static Registry& get_registry() {
+    static Registry registry;
+    return registry;
+}
+
+static ThreadData& get_thread_data() {
+    static thread_local std::shared_ptr<ThreadData> data = []() {
+        auto data = std::make_shared<ThreadData>();
+
+        Registry& registry = get_registry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        data->tid = registry.threads.size() + 1;
+        registry.threads.push_back(data);
+        return data;
+    }();
+
+    return *data;
+}
+
+/// Reads the GCL_TRACE and GCL_TRACE_FILE environment variables on startup.
+static const bool g_env_init = []() {
+    const char* trace = std::getenv("GCL_TRACE");
+    if (trace == nullptr || std::string(trace) == "0")
+        return false;
+
+    trace::set_enabled(true);
+    trace::set_tracing(true);
+
+    const char* path = std::getenv("GCL_TRACE_FILE");
+    if (path != nullptr) {
+        get_registry().path = path;
+        std::atexit([]() {
+            trace::write_chrome_trace(get_registry().path);
+        });
+    }
+
+    return true;
+}();
+
+const char* trace::to_string(Counter counter) {
+    switch (counter) {
+    case Counter::BytesUploaded:
+        return "bytes_uploaded";
+    case Counter::BytesDownloaded:
+        return "bytes_downloaded";
+    case Counter::Dispatches:
+        return "dispatches";
+    case Counter::HostDispatches:
+        return "host_dispatches";
+    case Counter::Submits:
+        return "submits";
+    case Counter::SubmitNs:
+        return "submit_ns";
+    case Counter::FenceWaitNs:
+        return "fence_wait_ns";
+    case Counter::PipelineCreations:
+        return "pipeline_creations";
+    case Counter::PipelineCreateNs:
+        return "pipeline_create_ns";
+    case Counter::SpilledAllocations:
+        return "spilled_allocations";
+    case Counter::None:
+        break;
+    }
+
+    return "unknown";
+}
+
+void trace::set_enabled(bool enabled) {
+    if (enabled)
+        detail::g_flags.fetch_or(detail::COUNTERS_BIT);
+    else
+        detail::g_flags.fetch_and(~detail::COUNTERS_BIT);
+}
+
+void trace::set_tracing(bool tracing) {
+    if (tracing)
+        detail::g_flags.fetch_or(detail::EVENTS_BIT);
+    else
+        detail::g_flags.fetch_and(~detail::EVENTS_BIT);
+}
+
+void trace::detail::add(Counter counter, uint64_t n) {
+    std::atomic<uint64_t>& value =
+        get_thread_data().counters[static_cast<uint32_t>(counter)];
+
+    value.store(value.load(std::memory_order_relaxed) + n,
+        std::memory_order_relaxed);
+}
+
+void trace::detail::record_event(const char* name, uint64_t start_ns,
+                                 uint64_t end_ns) {
+    ThreadData& data = get_thread_data();
+    std::lock_guard<std::mutex> guard(data.events_lock);
+
+    if (data.events.size() >= MAX_EVENTS_PER_THREAD) {
+        ++data.dropped;
+        return;
+    }
+
+    data.events.push_back({ name, start_ns, end_ns });
+}
+
+trace::Counters trace::snapshot() {
+    Counters counters {};
+
+    Registry& registry = get_registry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    for (const auto& data : registry.threads) {
+        for (uint32_t idx = 0; idx < NUM_COUNTERS; ++idx) {
+            counters.values[idx] +=
+                data->counters[idx].load(std::memory_order_relaxed);
+        }
+    }
+
+    return counters;
+}
+
+void trace::reset() {
+    Registry& registry = get_registry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    for (const auto& data : registry.threads) {
+        // Racy against the owning thread adding concurrently, in which case
+        // that one addition may survive the reset.
+        for (auto& counter : data->counters)
+            counter.store(0, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> events_guard(data->events_lock);
+        data->events.clear();
+        data->dropped = 0;
+    }
+}
+
+/// Write |str| to |os| as a JSON string literal.
+static void write_json_string(std::ostream& os, const char* str) {
+    os << '"';
+    for (const char* c = str; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\')
+            os << '\\';
+
+        os << *c;
+    }
+
+    os << '"';
+}
+
+bool trace::write_chrome_trace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file.is_open())
+        return false;
+
+    // Timestamps and durations are in microseconds, keep the fraction.
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    Registry& registry = get_registry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    bool first = true;
+    for (const auto& data : registry.threads) {
+        std::lock_guard<std::mutex> events_guard(data->events_lock);
+
+        if (!first)
+            file << ',';
+
+        first = false;
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+             << data->tid << ",\"args\":{\"name\":\"gcl thread "
+             << data->tid << "\"}}";
+
+        for (const Event& event : data->events) {
+            file << ",{\"name\":";
+            write_json_string(file, event.name);
+            file << ",\"cat\":\"gcl\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                 << data->tid
+                 << ",\"ts\":" << event.start_ns / 1000.0
+                 << ",\"dur\":" << (event.end_ns - event.start_ns) / 1000.0
+                 << '}';
+        }
+
+        // Emit the final counter values as a counter event per thread.
+        uint64_t end_ns = data->events.empty() 
+            ? 0 
+            : data->events.back().end_ns;
+        file << ",{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":"
+             << data->tid << ",\"ts\":" << end_ns / 1000.0 << ",\"args\":{";
+
+        for (uint32_t idx = 0; idx < NUM_COUNTERS; ++idx) {
+            if (idx != 0)
+                file << ',';
+
+            file << '"' << to_string(static_cast<Counter>(idx)) << "\":"
+                 << data->counters[idx].load(std::memory_order_relaxed);
+        }
+
+        file << ",\"dropped_events\":" << data->dropped << "}}";
+    }
+
+    file << "]}\n";
+    return file.good();
+}
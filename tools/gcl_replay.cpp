@@ -0,0 +1,499 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/Capture.h"
+#include "../include/GCLContext.h"
+#include "../include/Kernel.h"
+#include "../include/Program.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace gcl;
+using Record = capture::Record;
+using Type = Record::Type;
+
+/// Timings of one kind of operation.
+struct Stats {
+    uint64_t count = 0;
+    double total_us = 0.0;
+    double min_us = std::numeric_limits<double>::max();
+    double max_us = 0.0;
+
+    void add(double us) {
+        ++count;
+        total_us += us;
+        min_us = std::min(min_us, us);
+        max_us = std::max(max_us, us);
+    }
+};
+
+struct Options {
+    std::string path;
+    uint32_t repeat = 1;
+    bool per_dispatch = false;
+    uint64_t host_threshold = 0;
+};
+
+/// Returns the number of microseconds that |fn| takes.
+template<typename Fn>
+static double time_us(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/// Returns the entry of |id| in |objects|, or throws if there is none, which
+/// means the object was created before the capture started.
+template<typename T>
+static T& lookup(std::unordered_map<uint64_t, std::unique_ptr<T>>& objects,
+                 uint64_t id, const char* what) {
+    auto it = objects.find(id);
+    if (it == objects.end()) {
+        throw rt_error(std::string("unknown ") + what
+            + ", it was created before the capture started.");
+    }
+
+    return *it->second;
+}
+
+/// A dispatch of a captured program run.
+struct StepRecord {
+    Type type = Type::Dispatch;
+    uint64_t kernel = 0;
+    uint32_t x = 0;
+    uint32_t y = 1;
+    uint32_t z = 1;
+
+    /// The argument buffer and byte offset of an indirect dispatch.
+    uint64_t args = 0;
+    uint64_t offset = 0;
+
+    std::vector<uint8_t> push;
+
+    bool operator==(const StepRecord&) const = default;
+};
+
+/// A program rebuilt from a capture, kept across runs as the captured one
+/// was, and the steps it was built from.
+struct ReplayProgram {
+    std::unique_ptr<Program> program;
+    std::vector<StepRecord> steps;
+};
+
+/// Re-executes a captured stream of calls on a context.
+class Replayer final {
+    GCLContext& m_context;
+    const Options& m_options;
+
+    std::unordered_map<uint64_t, std::unique_ptr<Buffer<uint32_t>>> m_buffers;
+    std::unordered_map<uint64_t, std::unique_ptr<Kernel>> m_kernels;
+    std::unordered_map<uint64_t, std::string> m_names;
+
+    /// The programs by captured id. A program is only rebuilt when its steps
+    /// change, so that, like the captured process, runs re-record it only
+    /// when those change or its kernels are rebound.
+    std::unordered_map<uint64_t, ReplayProgram> m_programs;
+
+    /// Single-step timed programs by kernel id, through which dispatches
+    /// outside programs run with --per-dispatch to be timed on the device.
+    std::unordered_map<uint64_t, std::unique_ptr<Program>> m_timers;
+
+    /// The steps of the program run between BeginProgram and EndProgram,
+    /// and the push constants of its next step.
+    bool m_in_program = false;
+    std::vector<StepRecord> m_steps;
+    std::vector<uint8_t> m_step_push;
+
+    uint64_t m_dispatch_index = 0;
+
+    /// Forget the programs that use the kernel or buffer |id|, which is
+    /// being destroyed.
+    void forget_programs(uint64_t id) {
+        std::erase_if(m_programs, [&](const auto& entry) {
+            for (const StepRecord& step : entry.second.steps) {
+                if (step.kernel == id || step.args == id)
+                    return true;
+            }
+
+            return false;
+        });
+    }
+
+    /// Add |step| to |program|, using the push constants captured for the
+    /// step without changing those of its kernel for plain dispatches.
+    void add_step(Program& program, const StepRecord& step) {
+        Kernel& kernel = lookup(m_kernels, step.kernel, "kernel");
+
+        std::vector<uint8_t> saved = kernel.get_push();
+        kernel.push_bytes(step.push.data(),
+            static_cast<uint32_t>(step.push.size()));
+
+        if (step.type == Type::DispatchIndirect) {
+            program.add_indirect(kernel,
+                lookup(m_buffers, step.args, "buffer"), step.offset);
+        } else {
+            program.add(kernel, step.x, step.y, step.z);
+        }
+
+        kernel.push_bytes(saved.data(), static_cast<uint32_t>(saved.size()));
+    }
+
+    /// Run the program |id| with the steps collected since BeginProgram.
+    void run_program(uint64_t id) {
+        ReplayProgram& replay = m_programs[id];
+        if (replay.program == nullptr || replay.steps != m_steps) {
+            if (replay.program == nullptr)
+                replay.program = std::make_unique<Program>(m_context);
+
+            replay.program->clear();
+            for (const StepRecord& step : m_steps)
+                add_step(*replay.program, step);
+
+            replay.steps = std::move(m_steps);
+        }
+
+        m_steps.clear();
+
+        if (m_options.per_dispatch)
+            replay.program->set_timed(true);
+
+        std::string name = "program of "
+            + std::to_string(replay.program->size()) + " dispatches";
+        double us = time_us([&]() { replay.program->run(); });
+        operations[name].add(us);
+
+        if (!m_options.per_dispatch)
+            return;
+
+        std::cout << std::setw(8) << m_dispatch_index++ << "  "
+            << name << "  " << us << " us\n";
+
+        std::vector<double> step_us = replay.program->get_step_us();
+        for (uint32_t i = 0; i < step_us.size(); ++i) {
+            const StepRecord& step = replay.steps[i];
+            const std::string& kernel = m_names.at(step.kernel);
+            device[kernel].add(step_us[i]);
+
+            std::cout << std::setw(8) << "" << "  step " << std::setw(4)
+                << std::left << i << std::setw(24) << kernel << std::right;
+            print_size(step);
+            std::cout << "  device " << step_us[i] << " us\n";
+        }
+    }
+
+    /// Run |step| alone through the timed program of its kernel, returning
+    /// the wall-clock time and setting |device_us| to the device time.
+    double run_timed(const StepRecord& step, double& device_us) {
+        std::unique_ptr<Program>& timer = m_timers[step.kernel];
+        if (timer == nullptr) {
+            timer = std::make_unique<Program>(m_context);
+            timer->set_timed(true);
+        }
+
+        timer->clear();
+        add_step(*timer, step);
+
+        double us = time_us([&]() { timer->run(); });
+        std::vector<double> step_us = timer->get_step_us();
+        device_us = step_us.empty() ? 0.0 : step_us[0];
+        return us;
+    }
+
+    static void print_size(const StepRecord& step) {
+        if (step.type == Type::DispatchIndirect)
+            std::cout << "  indirect";
+        else
+            std::cout << "  " << step.x << " x " << step.y << " x " << step.z;
+    }
+
+public:
+    /// Timings by kernel name, and of everything else by operation.
+    std::map<std::string, Stats> kernels;
+    std::map<std::string, Stats> operations;
+
+    /// Device time by kernel name, measured with --per-dispatch.
+    std::map<std::string, Stats> device;
+
+    Replayer(GCLContext& context, const Options& options)
+            : m_context(context), m_options(options) {}
+
+    ~Replayer() {
+        // Programs refer to kernels, and kernels hold descriptors of the
+        // buffers, so they go in that order.
+        m_programs.clear();
+        m_timers.clear();
+        m_kernels.clear();
+        m_buffers.clear();
+    }
+
+    /// Replay the dispatch |step| outside a program with |fn|, or
+    /// through a timed program with --per-dispatch.
+    template<typename Fn>
+    void dispatch(const StepRecord& step, Fn&& fn) {
+        const std::string& name = m_names.at(step.kernel);
+        if (!m_options.per_dispatch) {
+            kernels[name].add(time_us(fn));
+            return;
+        }
+
+        double device_us = 0.0;
+        double us = run_timed(step, device_us);
+        kernels[name].add(us);
+        device[name].add(device_us);
+
+        std::cout << std::setw(8) << m_dispatch_index++ << "  "
+            << std::left << std::setw(24) << name << std::right;
+        print_size(step);
+        std::cout << "  " << us << " us  device " << device_us << " us\n";
+    }
+
+    void replay(const Record& record) {
+        switch (record.type) {
+        case Type::CreateBuffer:
+            m_buffers[record.id] = std::make_unique<Buffer<uint32_t>>(
+                m_context, record.size / sizeof(uint32_t));
+            break;
+        case Type::DestroyBuffer:
+            forget_programs(record.id);
+            m_buffers.erase(record.id);
+            break;
+        case Type::CreateKernel: {
+            if (record.data.empty()) {
+                throw rt_error("kernel " + record.name
+                    + " was captured without SPIR-V.");
+            }
+
+            std::span<const uint32_t> spirv(
+                reinterpret_cast<const uint32_t*>(record.data.data()),
+                record.data.size() / sizeof(uint32_t));
+
+            // Kernels embedded in the library keep their host
+            // implementations, as they had in the captured process.
+            const embedded::Spirv* shipped = embedded::find(record.name);
+            bool host_impl = shipped != nullptr
+                && std::equal(shipped->code.begin(), shipped->code.end(),
+                    spirv.begin(), spirv.end());
+
+            m_kernels[record.id] = std::make_unique<Kernel>(
+                m_context, record.name, spirv, host_impl);
+            m_names[record.id] = record.name;
+            break;
+        }
+        case Type::DestroyKernel:
+            forget_programs(record.id);
+            m_timers.erase(record.id);
+            m_kernels.erase(record.id);
+            break;
+        case Type::Bind:
+            lookup(m_kernels, record.id, "kernel").bind(record.binding,
+                lookup(m_buffers, record.target, "buffer"));
+            break;
+        case Type::Push:
+            if (m_in_program) {
+                m_step_push = record.data;
+            } else {
+                lookup(m_kernels, record.id, "kernel").push_bytes(
+                    record.data.data(),
+                    static_cast<uint32_t>(record.data.size()));
+            }
+            break;
+        case Type::Send: {
+            Buffer<uint32_t>& buffer = lookup(m_buffers, record.id, "buffer");
+
+            // Without captured contents, zeros stand in for the data.
+            std::vector<uint32_t> words(
+                (record.size + sizeof(uint32_t) - 1) / sizeof(uint32_t), 0);
+            if (!record.data.empty()) {
+                std::memcpy(words.data(), record.data.data(),
+                    record.data.size());
+            }
+
+            operations["send"].add(time_us([&]() { buffer.send(words); }));
+            break;
+        }
+        case Type::Fetch: {
+            Buffer<uint32_t>& buffer = lookup(m_buffers, record.id, "buffer");
+            operations["fetch"].add(time_us([&]() { buffer.fetch(); }));
+            break;
+        }
+        case Type::Dispatch: {
+            Kernel& kernel = lookup(m_kernels, record.id, "kernel");
+
+            StepRecord step;
+            step.kernel = record.id;
+            step.x = record.x;
+            step.y = record.y;
+            step.z = record.z;
+            if (m_in_program) {
+                step.push = std::move(m_step_push);
+                m_steps.push_back(std::move(step));
+                m_step_push.clear();
+                break;
+            }
+
+            step.push = kernel.get_push();
+            dispatch(step, [&]() {
+                kernel.dispatch(static_cast<int32_t>(record.x),
+                    static_cast<int32_t>(record.y),
+                    static_cast<int32_t>(record.z));
+            });
+            break;
+        }
+        case Type::DispatchIndirect: {
+            Kernel& kernel = lookup(m_kernels, record.id, "kernel");
+            Buffer<uint32_t>& args = lookup(m_buffers, record.target,
+                "buffer");
+
+            StepRecord step;
+            step.type = Type::DispatchIndirect;
+            step.kernel = record.id;
+            step.args = record.target;
+            step.offset = record.size;
+            if (m_in_program) {
+                step.push = std::move(m_step_push);
+                m_steps.push_back(std::move(step));
+                m_step_push.clear();
+                break;
+            }
+
+            step.push = kernel.get_push();
+            dispatch(step, [&]() {
+                kernel.dispatch_indirect(args, record.size);
+            });
+            break;
+        }
+        case Type::BeginProgram:
+            m_in_program = true;
+            m_steps.clear();
+            m_step_push.clear();
+            break;
+        case Type::EndProgram:
+            m_in_program = false;
+            run_program(record.id);
+            break;
+        }
+    }
+};
+
+static void print_stats(const std::string& title,
+                        const std::map<std::string, Stats>& stats) {
+    if (stats.empty())
+        return;
+
+    std::cout << '\n' << std::left << std::setw(32) << title << std::right
+        << std::setw(10) << "count" << std::setw(14) << "total ms"
+        << std::setw(12) << "mean us" << std::setw(12) << "min us"
+        << std::setw(12) << "max us" << '\n';
+
+    for (const auto& [name, s] : stats) {
+        std::cout << std::left << std::setw(32) << name << std::right
+            << std::setw(10) << s.count
+            << std::setw(14) << s.total_us / 1e3
+            << std::setw(12) << s.total_us / s.count
+            << std::setw(12) << s.min_us
+            << std::setw(12) << s.max_us << '\n';
+    }
+}
+
+static void usage() {
+    std::cout << "usage: ./gcl_replay <capture> [--repeat N] [--per-dispatch]"
+        " [--host-threshold N]\n\n"
+        "Record a capture by running a program with GCL_CAPTURE=<file>, and\n"
+        "GCL_CAPTURE_CONTENTS=1 to include the data sent to buffers. Replay\n"
+        "on lavapipe by pointing VK_ICD_FILENAMES at its ICD manifest.\n\n"
+        "Timings are host wall-clock time around each blocking call, so they\n"
+        "include submission and waiting as the captured process saw them.\n"
+        "--per-dispatch also times every dispatch, including each step of a\n"
+        "program, on the device with timestamp queries. It runs dispatches\n"
+        "outside programs as one-step programs, always on the device.\n"
+        "Set GCL_TRACE to also trace the library's own scopes.\n";
+}
+
+int32_t main(int32_t argc, char** argv) {
+    Options options;
+    for (int32_t i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            options.repeat = std::max<uint32_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--per-dispatch") {
+            options.per_dispatch = true;
+        } else if (arg == "--host-threshold" && i + 1 < argc) {
+            options.host_threshold = std::stoull(argv[++i]);
+        } else if (options.path.empty() && arg[0] != '-') {
+            options.path = arg;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (options.path.empty()) {
+        usage();
+        return 1;
+    }
+
+    // The replay mustn't capture itself.
+    capture::stop();
+
+    try {
+        // Read the whole stream first, so that reading doesn't count.
+        std::vector<Record> records;
+        capture::Reader reader(options.path);
+        for (Record record; reader.next(record);)
+            records.push_back(std::move(record));
+
+        GCLContext ctx(Backend::Device);
+
+        // Replays measure the device unless asked to route to the host.
+        ctx.set_host_threshold(options.host_threshold);
+
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(ctx.get_physical_device(), &props);
+        std::cout << "device: " << props.deviceName << '\n';
+        std::cout << "records: " << records.size() << '\n';
+
+        double best_us = std::numeric_limits<double>::max();
+        std::unique_ptr<Replayer> best;
+
+        for (uint32_t run = 0; run < options.repeat; ++run) {
+            auto replayer = std::make_unique<Replayer>(ctx, options);
+            double us = time_us([&]() {
+                for (const Record& record : records)
+                    replayer->replay(record);
+            });
+
+            std::cout << "run " << run << ": " << us / 1e3 << " ms\n";
+            if (us < best_us) {
+                best_us = us;
+                best = std::move(replayer);
+            }
+        }
+
+        print_stats("kernel", best->kernels);
+        print_stats("kernel device time", best->device);
+        print_stats("operation", best->operations);
+    } catch (const std::exception& e) {
+        std::cerr << "gcl_replay: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,743 @@
+//
+// Copyright (c) 2025 Nick Marino
+// All rights reserved.
+//
+
+#include "../include/Buffer.h"
+#include "../include/GCLContext.h"
+#include "../include/Kernel.h"
+#include "../include/Program.h"
+#include "../include/RemoteProtocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace gcl;
+
+/// The most dispatches submitted together in one batch.
+static constexpr uint32_t MAX_BATCH = 64;
+
+/// The most epoll events handled per wakeup.
+static constexpr int MAX_EVENTS = 64;
+
+/// The epoll tags of the daemon's own descriptors. Clients are tagged with
+/// their id, which starts after these.
+static constexpr uint64_t TAG_LISTEN = 0;
+static constexpr uint64_t TAG_STOP = 1;
+static constexpr uint64_t TAG_BATCH = 2;
+static constexpr uint64_t FIRST_CLIENT = 16;
+
+/// Shared memory of a client, mapped at an address aligned for import.
+struct Mapping {
+    /// The whole reserved range, which is unmapped as one.
+    void* reservation = MAP_FAILED;
+    uint64_t reserved = 0;
+
+    /// The aligned start of the shared memory within the reservation.
+    void* data = nullptr;
+
+    Mapping() = default;
+
+    Mapping(const Mapping&) = delete;
+    void operator=(const Mapping&) = delete;
+
+    ~Mapping() {
+        if (reservation != MAP_FAILED)
+            munmap(reservation, reserved);
+    }
+};
+
+/// A client buffer. It wraps the shared memory directly if the device can
+/// import it, and is otherwise a device buffer that the shared memory is
+/// copied into before every dispatch that uses it, and back after.
+struct ClientBuffer {
+    Mapping mapping;
+    uint64_t size = 0;
+    bool imported = false;
+    std::unique_ptr<Buffer<uint32_t>> buf;
+};
+
+struct ClientKernel {
+    std::unique_ptr<Kernel> kernel;
+
+    /// The buffer ids currently bound, to skip redundant descriptor updates.
+    uint32_t bound[remote::MAX_BINDINGS] = {};
+};
+
+/// A received request and the descriptor sent with it, if any.
+struct Pending {
+    remote::Request request;
+    int fd = -1;
+};
+
+struct Client {
+    uint64_t id = 0;
+    int socket = -1;
+    bool hello = false;
+
+    /// If true, the client has disconnected, and is destroyed once its
+    /// dispatch in the running batch, if any, has finished.
+    bool closed = false;
+
+    /// If true, a dispatch of this client is in the running batch. Its later
+    /// requests wait, as they could change the bindings of that dispatch.
+    bool in_flight = false;
+
+    uint32_t next_id = 1;
+    std::unordered_map<uint32_t, std::unique_ptr<ClientBuffer>> buffers;
+    std::unordered_map<uint32_t, std::unique_ptr<ClientKernel>> kernels;
+    std::deque<Pending> queue;
+
+    ~Client() {
+        for (Pending& pending : queue) {
+            if (pending.fd >= 0)
+                close(pending.fd);
+        }
+
+        // Kernels hold descriptors of the buffers, so they go first.
+        kernels.clear();
+        buffers.clear();
+
+        if (socket >= 0)
+            close(socket);
+    }
+};
+
+/// Returns |what| followed by the description of errno.
+static rt_error sys_error(const std::string& what) {
+    return rt_error(what + ": " + std::strerror(errno));
+}
+
+/// Returns |n| rounded up to a multiple of |alignment|.
+static uint64_t align_up(uint64_t n, uint64_t alignment) {
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+/// Map |size| bytes of |fd| into |mapping| at an address aligned to
+/// |alignment|, which is a multiple of the page size.
+static void map_aligned(int fd, uint64_t size, uint64_t alignment,
+                        Mapping& mapping) {
+    // If the client could shrink the memory under the mapping, accessing it
+    // would raise SIGBUS here, or fault the device that imported it.
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || !(seals & F_SEAL_SHRINK))
+        throw rt_error("shared memory must be sealed with F_SEAL_SHRINK.");
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0)
+        throw sys_error("failed to stat shared memory");
+
+    if (static_cast<uint64_t>(st.st_size) < size)
+        throw rt_error("shared memory is smaller than requested.");
+
+    // Reserve enough to align the start, then map over the aligned part.
+    mapping.reserved = size + alignment;
+    mapping.reservation = mmap(nullptr, mapping.reserved, PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping.reservation == MAP_FAILED)
+        throw sys_error("failed to reserve address space");
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(mapping.reservation);
+    void* aligned = reinterpret_cast<void*>(align_up(start, alignment));
+
+    mapping.data = mmap(aligned, size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_FIXED, fd, 0);
+    if (mapping.data == MAP_FAILED) {
+        mapping.data = nullptr;
+        throw sys_error("failed to map shared memory");
+    }
+}
+
+/// Multiplexes the device of one context across client processes. Clients
+/// send requests over a Unix socket, and the dispatches of all clients are
+/// batched into single submissions, taking one dispatch from each client in
+/// turn, so that no client can starve the others.
+class Daemon final {
+    GCLContext& m_context;
+    std::string m_path;
+
+    int m_listen = -1;
+    int m_epoll = -1;
+    int m_stop = -1;
+
+    /// The alignment that clients size shared memory to.
+    uint64_t m_alignment = 0;
+
+    /// The most workgroups the device dispatches in each dimension.
+    uint32_t m_max_groups[3] = {};
+
+    std::map<uint64_t, std::unique_ptr<Client>> m_clients;
+    uint64_t m_next_client = FIRST_CLIENT;
+
+    /// The client that the next batch starts from.
+    uint64_t m_next_turn = FIRST_CLIENT;
+
+    /// The running batch, its completion, and the dispatches in it.
+    Program m_program;
+    std::optional<Completion> m_running;
+    std::vector<std::pair<Client*, ClientKernel*>> m_batch;
+
+    void watch(int fd, uint64_t tag) {
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.u64 = tag;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+            throw sys_error("failed to watch descriptor");
+    }
+
+    void reply(Client& client, const remote::Reply& reply) {
+        if (client.closed)
+            return;
+
+        // Clients wait for every reply, so the socket never fills up. If the
+        // client is gone, the hangup is handled by the event loop.
+        send(client.socket, &reply, sizeof(reply), MSG_NOSIGNAL);
+    }
+
+    void reply_error(Client& client, const std::string& error) {
+        remote::Reply reply;
+        reply.status = 1;
+        std::strncpy(reply.error, error.c_str(), remote::MAX_ERROR - 1);
+        this->reply(client, reply);
+    }
+
+    void accept_clients() {
+        int fd;
+        while ((fd = accept4(m_listen, nullptr, nullptr,
+                  SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            auto client = std::make_unique<Client>();
+            client->id = m_next_client++;
+            client->socket = fd;
+            watch(fd, client->id);
+            m_clients.emplace(client->id, std::move(client));
+        }
+    }
+
+    /// Receive every request that |client| has sent. Returns false if it
+    /// disconnected or broke the protocol.
+    bool receive(Client& client) {
+        while (true) {
+            Pending pending;
+
+            iovec iov {};
+            iov.iov_base = &pending.request;
+            iov.iov_len = sizeof(pending.request);
+
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+            msghdr msg {};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            ssize_t received = recvmsg(client.socket, &msg, MSG_CMSG_CLOEXEC);
+            if (received < 0 && errno == EINTR)
+                continue;
+
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return true;
+
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+                    cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if (cmsg->cmsg_level == SOL_SOCKET
+                      && cmsg->cmsg_type == SCM_RIGHTS) {
+                    std::memcpy(&pending.fd, CMSG_DATA(cmsg), sizeof(int));
+                }
+            }
+
+            bool valid = received == sizeof(pending.request)
+                && !(msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC));
+            if (!valid) {
+                if (pending.fd >= 0)
+                    close(pending.fd);
+
+                return false;
+            }
+
+            client.queue.push_back(pending);
+        }
+    }
+
+    /// Forget |client|, now or once its running dispatch has finished.
+    void disconnect(Client& client) {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, client.socket, nullptr);
+        client.closed = true;
+
+        if (!client.in_flight)
+            m_clients.erase(client.id);
+    }
+
+    void create_buffer(Client& client, const Pending& pending) {
+        if (pending.fd < 0)
+            throw rt_error("no shared memory sent with the buffer.");
+
+        const uint64_t size = pending.request.size;
+        if (size == 0 || size % sizeof(uint32_t) != 0)
+            throw rt_error("buffer size must be a nonzero multiple of 4.");
+
+        auto buffer = std::make_unique<ClientBuffer>();
+        buffer->size = size;
+        map_aligned(pending.fd, align_up(size, m_alignment), m_alignment,
+            buffer->mapping);
+
+        const uint64_t words = size / sizeof(uint32_t);
+        if (m_context.get_host_import_alignment() != 0) {
+            try {
+                buffer->buf = std::make_unique<Buffer<uint32_t>>(
+                    m_context, buffer->mapping.data, words);
+                buffer->imported = true;
+            } catch (const rt_error&) {
+                // Some memory can't be imported, copy it instead.
+            }
+        }
+
+        if (!buffer->imported)
+            buffer->buf = std::make_unique<Buffer<uint32_t>>(m_context, words);
+
+        remote::Reply reply;
+        reply.id = client.next_id++;
+        client.buffers.emplace(reply.id, std::move(buffer));
+        this->reply(client, reply);
+    }
+
+    void create_kernel(Client& client, const Pending& pending) {
+        if (pending.fd < 0)
+            throw rt_error("no SPIR-V sent with the kernel.");
+
+        const uint64_t size = pending.request.size;
+        if (size == 0 || size % sizeof(uint32_t) != 0)
+            throw rt_error("SPIR-V size must be a nonzero multiple of 4.");
+
+        Mapping mapping;
+        map_aligned(pending.fd, align_up(size, m_alignment), m_alignment,
+            mapping);
+
+        const uint32_t* words = static_cast<const uint32_t*>(mapping.data);
+        std::vector<uint32_t> spirv(words, words + size / sizeof(uint32_t));
+
+        char name[remote::MAX_NAME];
+        std::memcpy(name, pending.request.name, remote::MAX_NAME);
+        name[remote::MAX_NAME - 1] = '\0';
+
+        auto kernel = std::make_unique<ClientKernel>();
+        kernel->kernel = std::make_unique<Kernel>(m_context, name, spirv);
+
+        for (uint32_t binding : kernel->kernel->get_bindings()) {
+            if (binding >= remote::MAX_BINDINGS) {
+                throw rt_error("kernel uses binding "
+                    + std::to_string(binding) + ", beyond the remote maximum.");
+            }
+        }
+
+        remote::Reply reply;
+        reply.id = client.next_id++;
+        reply.value = kernel->kernel->get_local_size_x();
+        client.kernels.emplace(reply.id, std::move(kernel));
+        this->reply(client, reply);
+    }
+
+    void destroy_buffer(Client& client, uint32_t id) {
+        if (client.buffers.erase(id) == 0)
+            throw rt_error("no such buffer.");
+
+        // Make the next dispatch of any kernel it was bound to rebind.
+        for (auto& [kernel_id, kernel] : client.kernels) {
+            for (uint32_t& bound : kernel->bound) {
+                if (bound == id)
+                    bound = 0;
+            }
+        }
+
+        reply(client, remote::Reply());
+    }
+
+    /// Bind and push the state of a dispatch request, and add it to the
+    /// next batch.
+    void add_dispatch(Client& client, const remote::Request& request) {
+        auto it = client.kernels.find(request.id);
+        if (it == client.kernels.end())
+            throw rt_error("no such kernel.");
+
+        ClientKernel& kernel = *it->second;
+
+        // A bad dispatch could lose the device for every client, so it is
+        // refused before anything is recorded.
+        if (request.x == 0 || request.y == 0 || request.z == 0)
+            throw rt_error("dispatch dimensions must be nonzero.");
+
+        const uint64_t local_size = kernel.kernel->get_local_size_x();
+        const uint64_t groups[3] = {
+            (request.x + local_size - 1) / local_size, request.y, request.z
+        };
+
+        for (uint32_t dim = 0; dim < 3; ++dim) {
+            if (groups[dim] > m_max_groups[dim]) {
+                throw rt_error("dispatch of " + std::to_string(groups[dim])
+                    + " groups in dimension " + std::to_string(dim)
+                    + " exceeds the device limit of "
+                    + std::to_string(m_max_groups[dim]) + ".");
+            }
+        }
+
+        if (request.push_size > remote::MAX_PUSH)
+            throw rt_error("push constants exceed the remote maximum.");
+
+        // The bindings are checked before any is changed, so that a refused
+        // dispatch leaves the kernel as it was.
+        const std::vector<uint32_t>& declared = kernel.kernel->get_bindings();
+        for (uint32_t binding = 0; binding < remote::MAX_BINDINGS;
+                ++binding) {
+            uint32_t id = request.bindings[binding];
+            if (id == 0)
+                continue;
+
+            // Writing a descriptor the shader doesn't declare is invalid.
+            if (std::find(declared.begin(), declared.end(), binding)
+                  == declared.end()) {
+                throw rt_error("binding " + std::to_string(binding)
+                    + " is not declared by the kernel.");
+            }
+
+            if (client.buffers.find(id) == client.buffers.end())
+                throw rt_error("no such buffer.");
+        }
+
+        // Unbound descriptors hold garbage that the device would access.
+        for (uint32_t binding : declared) {
+            if (request.bindings[binding] == 0 && kernel.bound[binding] == 0) {
+                throw rt_error("binding " + std::to_string(binding)
+                    + " of the kernel is unbound.");
+            }
+        }
+
+        for (uint32_t binding : declared) {
+            uint32_t id = request.bindings[binding];
+            if (id == 0 || id == kernel.bound[binding])
+                continue;
+
+            kernel.kernel->bind(binding, *client.buffers.at(id)->buf);
+            kernel.bound[binding] = id;
+        }
+
+        kernel.kernel->push_bytes(request.push, request.push_size);
+        m_program.add(*kernel.kernel, request.x, request.y, request.z);
+
+        client.in_flight = true;
+        m_batch.emplace_back(&client, &kernel);
+    }
+
+    /// Handle the requests of |client| up to and including its next
+    /// dispatch.
+    void serve(Client& client) {
+        while (!client.queue.empty() && !client.in_flight) {
+            Pending pending = client.queue.front();
+            client.queue.pop_front();
+
+            const remote::Request& request = pending.request;
+
+            try {
+                if (!client.hello && request.op != remote::Op::Hello)
+                    throw rt_error("expected a hello first.");
+
+                switch (request.op) {
+                case remote::Op::Hello: {
+                    if (request.size != remote::PROTOCOL_VERSION)
+                        throw rt_error("protocol version mismatch.");
+
+                    client.hello = true;
+                    remote::Reply reply;
+                    reply.value = m_alignment;
+                    this->reply(client, reply);
+                    break;
+                }
+                case remote::Op::CreateBuffer:
+                    create_buffer(client, pending);
+                    break;
+                case remote::Op::DestroyBuffer:
+                    destroy_buffer(client, request.id);
+                    break;
+                case remote::Op::CreateKernel:
+                    create_kernel(client, pending);
+                    break;
+                case remote::Op::DestroyKernel:
+                    if (client.kernels.erase(request.id) == 0)
+                        throw rt_error("no such kernel.");
+
+                    reply(client, remote::Reply());
+                    break;
+                case remote::Op::Dispatch:
+                    add_dispatch(client, request);
+                    break;
+                default:
+                    throw rt_error("unknown request.");
+                }
+            } catch (const std::exception& e) {
+                reply_error(client, e.what());
+            }
+
+            if (pending.fd >= 0)
+                close(pending.fd);
+        }
+    }
+
+    /// Serve every client, starting from the one after the first served in
+    /// the previous round, and submit the dispatches they made as a batch.
+    void schedule() {
+        if (m_running)
+            return;
+
+        m_program.clear();
+        m_batch.clear();
+
+        auto start = m_clients.lower_bound(m_next_turn);
+        std::vector<Client*> order;
+        for (auto it = start; it != m_clients.end(); ++it)
+            order.push_back(it->second.get());
+        for (auto it = m_clients.begin(); it != start; ++it)
+            order.push_back(it->second.get());
+
+        for (Client* client : order) {
+            if (m_batch.size() == MAX_BATCH)
+                break;
+
+            serve(*client);
+            m_next_turn = client->id + 1;
+        }
+
+        if (m_batch.empty())
+            return;
+
+        // Buffers that couldn't be imported get the clients' data now.
+        for (auto& [client, kernel] : m_batch) {
+            for (uint32_t id : kernel->bound) {
+                if (id == 0)
+                    continue;
+
+                ClientBuffer& buffer = *client->buffers.at(id);
+                if (buffer.imported)
+                    continue;
+
+                void* p = nullptr;
+                buffer.buf->map(&p);
+                std::memcpy(p, buffer.mapping.data, buffer.size);
+                buffer.buf->flush();
+                buffer.buf->unmap();
+            }
+        }
+
+        m_running = m_program.run_async();
+        watch(m_running->fd(), TAG_BATCH);
+    }
+
+    /// Finish the running batch and reply to every dispatch in it.
+    void finish() {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, m_running->fd(), nullptr);
+        m_running->wait();
+        m_running.reset();
+
+        for (auto& [client, kernel] : m_batch) {
+            client->in_flight = false;
+            if (client->closed) {
+                m_clients.erase(client->id);
+                continue;
+            }
+
+            for (uint32_t id : kernel->bound) {
+                if (id == 0)
+                    continue;
+
+                ClientBuffer& buffer = *client->buffers.at(id);
+                if (buffer.imported)
+                    continue;
+
+                void* p = nullptr;
+                buffer.buf->invalidate();
+                buffer.buf->map(&p);
+                std::memcpy(buffer.mapping.data, p, buffer.size);
+                buffer.buf->unmap();
+            }
+
+            reply(*client, remote::Reply());
+        }
+
+        m_batch.clear();
+    }
+
+public:
+    Daemon(GCLContext& context, const std::string& path)
+            : m_context(context), m_path(path), m_program(context) {
+        m_alignment = std::max<uint64_t>(
+            sysconf(_SC_PAGESIZE), context.get_host_import_alignment());
+
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(context.get_physical_device(), &props);
+        std::copy(std::begin(props.limits.maxComputeWorkGroupCount),
+            std::end(props.limits.maxComputeWorkGroupCount), m_max_groups);
+
+        sockaddr_un addr {};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path))
+            throw rt_error("socket path too long: " + path);
+
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+        m_listen = socket(AF_UNIX,
+            SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_listen < 0)
+            throw sys_error("failed to create socket");
+
+        // A socket file left behind by a daemon that died is reused, but a
+        // live daemon is left alone.
+        int probe = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 && connect(probe,
+            reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        if (probe >= 0)
+            close(probe);
+
+        if (live)
+            throw rt_error("gcld is already running on " + path);
+
+        unlink(path.c_str());
+        if (bind(m_listen, reinterpret_cast<sockaddr*>(&addr),
+              sizeof(addr)) != 0)
+            throw sys_error("failed to bind " + path);
+
+        // Only processes of the same user may connect.
+        chmod(path.c_str(), 0600);
+
+        if (listen(m_listen, SOMAXCONN) != 0)
+            throw sys_error("failed to listen on " + path);
+
+        m_epoll = epoll_create1(EPOLL_CLOEXEC);
+        m_stop = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (m_epoll < 0 || m_stop < 0)
+            throw sys_error("failed to create event descriptors");
+
+        watch(m_listen, TAG_LISTEN);
+        watch(m_stop, TAG_STOP);
+    }
+
+    ~Daemon() {
+        if (m_running)
+            m_running->wait();
+
+        m_running.reset();
+        m_clients.clear();
+
+        close(m_stop);
+        close(m_epoll);
+        close(m_listen);
+        unlink(m_path.c_str());
+    }
+
+    Daemon(const Daemon&) = delete;
+    void operator=(const Daemon&) = delete;
+
+    /// Makes run() return. Safe to call from a signal handler.
+    void stop() {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = write(m_stop, &one, sizeof(one));
+    }
+
+    /// Serve clients until stop() is called.
+    void run() {
+        epoll_event events[MAX_EVENTS];
+
+        while (true) {
+            int count = epoll_wait(m_epoll, events, MAX_EVENTS, -1);
+            if (count < 0 && errno == EINTR)
+                continue;
+
+            if (count < 0)
+                throw sys_error("failed to wait for events");
+
+            for (int idx = 0; idx < count; ++idx) {
+                uint64_t tag = events[idx].data.u64;
+                if (tag == TAG_STOP)
+                    return;
+
+                if (tag == TAG_LISTEN) {
+                    accept_clients();
+                    continue;
+                }
+
+                if (tag == TAG_BATCH) {
+                    finish();
+                    continue;
+                }
+
+                auto it = m_clients.find(tag);
+                if (it == m_clients.end() || it->second->closed)
+                    continue;
+
+                Client& client = *it->second;
+                bool hangup = events[idx].events & (EPOLLHUP | EPOLLERR);
+                if (!receive(client) || hangup)
+                    disconnect(client);
+            }
+
+            schedule();
+        }
+    }
+};
+
+static Daemon* g_daemon = nullptr;
+
+static void on_signal(int) {
+    if (g_daemon != nullptr)
+        g_daemon->stop();
+}
+
+int32_t main(int32_t argc, char** argv) {
+    if (argc > 2) {
+        std::cout << "usage: ./gcld [socket path]" << std::endl;
+        return 1;
+    }
+
+    const std::string path = argc == 2
+        ? argv[1]
+        : remote::default_socket_path();
+
+    try {
+        GCLContext ctx(Backend::Device);
+        Daemon daemon(ctx, path);
+
+        g_daemon = &daemon;
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+
+        std::cout << "gcld listening on " << path << " ("
+            << (ctx.get_host_import_alignment() != 0
+                ? "importing shared memory"
+                : "copying shared memory") << ")" << std::endl;
+
+        daemon.run();
+        g_daemon = nullptr;
+    } catch (const std::exception& e) {
+        std::cerr << "gcld: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}